@@ -0,0 +1,495 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "router.h"
+#include "search_state.h"
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// иерархия сжатий (Contraction Hierarchies): предрасчёт по очереди сжимает вершины,
+	// добавляя шорткаты вместо путей через них, а запрос выполняется двунаправленным поиском
+	// только по рёбрам, ведущим вверх по иерархии. Сжатие и поиск работают только с ключами
+	// весов; полный вес получается из ключа, а данные рёбер - по номерам рёбер пути
+	template <typename Weight>
+	class ContractionHierarchy
+	{
+	private:
+		using Graph = FrozenGraph<Weight>;
+		using Key = typename WeightTraits<Weight>::Key;
+
+	public:
+		using RouteInfo = typename Router<Weight>::RouteInfo;
+
+		// шорткат заменяет путь из двух рёбер иерархии через сжатую вершину; вес шортката - ключ.
+		// id рёбер иерархии: [0, E) - рёбра исходного графа, [E, E + S) - шорткаты
+		struct Shortcut
+		{
+			Edge<Key> edge;
+			EdgeId first_edge;
+			EdgeId second_edge;
+		};
+
+		explicit ContractionHierarchy(const Graph& graph);
+		// восстанавливает ранее построенную иерархию, например после десериализации
+		ContractionHierarchy(const Graph& graph, std::vector<size_t> ranks, std::vector<Shortcut> shortcuts);
+
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+		const std::vector<size_t>& GetRanks() const;
+		const std::vector<Shortcut>& GetShortcuts() const;
+
+	private:
+		// ребро иерархии к соседу: при сжатии - с минимальным весом среди параллельных,
+		// в поисковом графе - вверх по иерархии, с весом рядом с соседом
+		struct NeighborEdge
+		{
+			VertexId vertex;
+			Key weight;
+			EdgeId edge_id;
+		};
+
+		// рабочее состояние сжатия: рёбра между ещё не сжатыми вершинами
+		struct ContractionState
+		{
+			std::vector<std::vector<EdgeId>> out_edges;
+			std::vector<std::vector<EdgeId>> in_edges;
+			std::vector<bool> contracted;
+			std::vector<int> contracted_neighbors;
+
+			// состояние поиска свидетелей, переиспользуемое между вызовами
+			SearchState<Key> witness;
+		};
+
+		// сколько вершин может извлечь поиск свидетеля, прежде чем шорткат будет добавлен без проверки
+		static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+
+		Edge<Key> GetHierarchyEdge(EdgeId edge_id) const;
+		void CheckWeights() const;
+
+		void Contract();
+		int ComputePriority(VertexId vertex, ContractionState& state) const;
+		std::vector<Shortcut> FindShortcuts(VertexId vertex, ContractionState& state) const;
+		std::vector<NeighborEdge> CollectNeighbors(VertexId vertex, const std::vector<EdgeId>& edge_ids,
+			const ContractionState& state, bool outgoing) const;
+		void RunWitnessSearch(VertexId source, VertexId excluded, const Key& max_weight, ContractionState& state) const;
+
+		void BuildSearchGraph();
+		void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+		static constexpr Key ZERO_KEY{};
+		const Graph& graph_;
+		std::vector<size_t> ranks_;
+		std::vector<Shortcut> shortcuts_;
+		// поисковый граф в формате CSR: рёбра вершины v - [offsets[v], offsets[v + 1])
+		std::vector<size_t> upward_offsets_;
+		std::vector<NeighborEdge> upward_edges_;    // рёбра из вершины в вершины с большим рангом
+		std::vector<size_t> downward_offsets_;
+		std::vector<NeighborEdge> downward_edges_;  // рёбра в вершину из вершин с большим рангом
+		// состояния прямого и обратного поиска, переиспользуемые между запросами
+		mutable SearchStatePool<Key> states_;
+	};
+
+	template <typename Weight>
+	ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+		: graph_(graph)
+	{
+		CheckWeights();
+		Contract();
+		BuildSearchGraph();
+	}
+
+	template <typename Weight>
+	ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, std::vector<size_t> ranks,
+		std::vector<Shortcut> shortcuts)
+		: graph_(graph)
+		, ranks_(std::move(ranks))
+		, shortcuts_(std::move(shortcuts))
+	{
+		if (ranks_.size() != graph_.GetVertexCount())
+		{
+			throw std::invalid_argument("Ranks count should match vertex count");
+		}
+		BuildSearchGraph();
+	}
+
+	template <typename Weight>
+	const std::vector<size_t>& ContractionHierarchy<Weight>::GetRanks() const
+	{
+		return ranks_;
+	}
+
+	template <typename Weight>
+	const std::vector<typename ContractionHierarchy<Weight>::Shortcut>& ContractionHierarchy<Weight>::GetShortcuts() const
+	{
+		return shortcuts_;
+	}
+
+	template <typename Weight>
+	Edge<typename ContractionHierarchy<Weight>::Key> ContractionHierarchy<Weight>::GetHierarchyEdge(EdgeId edge_id) const
+	{
+		const size_t edge_count = graph_.GetEdgeCount();
+		if (edge_id < edge_count)
+		{
+			return Edge<Key>{ graph_.GetEdgeSource(edge_id), graph_.GetEdgeTarget(edge_id), graph_.GetEdgeKey(edge_id) };
+		}
+		return shortcuts_.at(edge_id - edge_count).edge;
+	}
+
+	template <typename Weight>
+	void ContractionHierarchy<Weight>::CheckWeights() const
+	{
+		for (const Key& key : graph_.GetKeys())
+		{
+			if (key < ZERO_KEY)
+			{
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+		}
+	}
+
+	template <typename Weight>
+	void ContractionHierarchy<Weight>::Contract()
+	{
+		const size_t vertex_count = graph_.GetVertexCount();
+		ContractionState state;
+		state.out_edges.resize(vertex_count);
+		state.in_edges.resize(vertex_count);
+		for (VertexId vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			const auto out_edges = graph_.GetIncidentEdges(vertex);
+			state.out_edges[vertex].assign(out_edges.begin(), out_edges.end());
+			const auto in_edges = graph_.GetIncomingEdges(vertex);
+			state.in_edges[vertex].assign(in_edges.begin(), in_edges.end());
+		}
+		state.contracted.assign(vertex_count, false);
+		state.contracted_neighbors.assign(vertex_count, 0);
+
+		// очередь вершин по приоритету сжатия; приоритеты пересчитываются лениво при извлечении
+		using PriorityItem = std::pair<int, VertexId>;
+		std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> queue;
+		for (VertexId vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			queue.push({ ComputePriority(vertex, state), vertex });
+		}
+
+		ranks_.assign(vertex_count, 0);
+		size_t next_rank = 0;
+		while (!queue.empty())
+		{
+			const VertexId vertex = queue.top().second;
+			queue.pop();
+			const int priority = ComputePriority(vertex, state);
+			if (!queue.empty() && priority > queue.top().first)
+			{
+				queue.push({ priority, vertex });
+				continue;
+			}
+
+			for (Shortcut& shortcut : FindShortcuts(vertex, state))
+			{
+				const EdgeId edge_id = graph_.GetEdgeCount() + shortcuts_.size();
+				state.out_edges[shortcut.edge.from].push_back(edge_id);
+				state.in_edges[shortcut.edge.to].push_back(edge_id);
+				shortcuts_.push_back(std::move(shortcut));
+			}
+			state.contracted[vertex] = true;
+			ranks_[vertex] = next_rank++;
+			for (const EdgeId edge_id : state.out_edges[vertex])
+			{
+				++state.contracted_neighbors[GetHierarchyEdge(edge_id).to];
+			}
+			for (const EdgeId edge_id : state.in_edges[vertex])
+			{
+				++state.contracted_neighbors[GetHierarchyEdge(edge_id).from];
+			}
+		}
+	}
+
+	template <typename Weight>
+	int ContractionHierarchy<Weight>::ComputePriority(VertexId vertex, ContractionState& state) const
+	{
+		// разность рёбер: сколько шорткатов добавит сжатие против числа удаляемых рёбер
+		const int shortcuts_count = static_cast<int>(FindShortcuts(vertex, state).size());
+		const int removed_count = static_cast<int>(CollectNeighbors(vertex, state.in_edges[vertex], state, false).size()
+			+ CollectNeighbors(vertex, state.out_edges[vertex], state, true).size());
+		return shortcuts_count - removed_count + state.contracted_neighbors[vertex];
+	}
+
+	template <typename Weight>
+	std::vector<typename ContractionHierarchy<Weight>::NeighborEdge> ContractionHierarchy<Weight>::CollectNeighbors(
+		VertexId vertex, const std::vector<EdgeId>& edge_ids, const ContractionState& state, bool outgoing) const
+	{
+		std::vector<NeighborEdge> neighbors;
+		for (const EdgeId edge_id : edge_ids)
+		{
+			const auto edge = GetHierarchyEdge(edge_id);
+			const VertexId neighbor = outgoing ? edge.to : edge.from;
+			if (neighbor != vertex && !state.contracted[neighbor])
+			{
+				neighbors.push_back({ neighbor, edge.weight, edge_id });
+			}
+		}
+		// из параллельных рёбер к одному соседу достаточно самого лёгкого
+		std::sort(neighbors.begin(), neighbors.end(), [](const NeighborEdge& lhs, const NeighborEdge& rhs)
+		{
+			return lhs.vertex != rhs.vertex ? lhs.vertex < rhs.vertex : lhs.weight < rhs.weight;
+		});
+		neighbors.erase(std::unique(neighbors.begin(), neighbors.end(), [](const NeighborEdge& lhs, const NeighborEdge& rhs)
+		{
+			return lhs.vertex == rhs.vertex;
+		}), neighbors.end());
+		return neighbors;
+	}
+
+	template <typename Weight>
+	std::vector<typename ContractionHierarchy<Weight>::Shortcut> ContractionHierarchy<Weight>::FindShortcuts(
+		VertexId vertex, ContractionState& state) const
+	{
+		std::vector<Shortcut> shortcuts;
+		const auto in_neighbors = CollectNeighbors(vertex, state.in_edges[vertex], state, false);
+		const auto out_neighbors = CollectNeighbors(vertex, state.out_edges[vertex], state, true);
+		if (in_neighbors.empty() || out_neighbors.empty())
+		{
+			return shortcuts;
+		}
+
+		for (const auto& in : in_neighbors)
+		{
+			std::optional<Key> max_weight;
+			for (const auto& out : out_neighbors)
+			{
+				const Key candidate_weight = in.weight + out.weight;
+				if (out.vertex != in.vertex && (!max_weight || *max_weight < candidate_weight))
+				{
+					max_weight = candidate_weight;
+				}
+			}
+			if (!max_weight)
+			{
+				continue;
+			}
+
+			RunWitnessSearch(in.vertex, vertex, *max_weight, state);
+			for (const auto& out : out_neighbors)
+			{
+				if (out.vertex == in.vertex)
+				{
+					continue;
+				}
+				const Key candidate_weight = in.weight + out.weight;
+				// путь в обход сжимаемой вершины не длиннее - шорткат не нужен
+				if (state.witness.IsReached(out.vertex) && !(candidate_weight < state.witness.GetWeight(out.vertex)))
+				{
+					continue;
+				}
+				shortcuts.push_back({ Edge<Key>{ in.vertex, out.vertex, candidate_weight }, in.edge_id, out.edge_id });
+			}
+		}
+		return shortcuts;
+	}
+
+	template <typename Weight>
+	void ContractionHierarchy<Weight>::RunWitnessSearch(VertexId source, VertexId excluded, const Key& max_weight,
+		ContractionState& state) const
+	{
+		auto& witness = state.witness;
+		witness.Reset(graph_.GetVertexCount());
+		witness.Reach(source, ZERO_KEY, SearchState<Key>::NO_EDGE);
+		witness.Push(ZERO_KEY, ZERO_KEY, source);
+		size_t settled_count = 0;
+		while (!witness.IsQueueEmpty() && settled_count < WITNESS_SETTLE_LIMIT)
+		{
+			const auto item = witness.Pop();
+			if (witness.GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			if (max_weight < item.weight)
+			{
+				break;
+			}
+			++settled_count;
+			for (const EdgeId edge_id : state.out_edges[item.vertex])
+			{
+				const auto edge = GetHierarchyEdge(edge_id);
+				if (edge.to == excluded || state.contracted[edge.to])
+				{
+					continue;
+				}
+				const Key candidate_weight = item.weight + edge.weight;
+				if (!witness.IsReached(edge.to) || candidate_weight < witness.GetWeight(edge.to))
+				{
+					witness.Reach(edge.to, candidate_weight, edge_id);
+					witness.Push(candidate_weight, candidate_weight, edge.to);
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	void ContractionHierarchy<Weight>::BuildSearchGraph()
+	{
+		const size_t vertex_count = graph_.GetVertexCount();
+		const size_t hierarchy_edge_count = graph_.GetEdgeCount() + shortcuts_.size();
+		upward_offsets_.assign(vertex_count + 1, 0);
+		downward_offsets_.assign(vertex_count + 1, 0);
+		for (EdgeId edge_id = 0; edge_id < hierarchy_edge_count; ++edge_id)
+		{
+			const auto edge = GetHierarchyEdge(edge_id);
+			if (ranks_.at(edge.from) < ranks_.at(edge.to))
+			{
+				++upward_offsets_[edge.from + 1];
+			}
+			else if (ranks_[edge.from] > ranks_[edge.to])
+			{
+				++downward_offsets_[edge.to + 1];
+			}
+		}
+		std::partial_sum(upward_offsets_.begin(), upward_offsets_.end(), upward_offsets_.begin());
+		std::partial_sum(downward_offsets_.begin(), downward_offsets_.end(), downward_offsets_.begin());
+
+		// рёбра вершины раскладываются по возрастанию номера
+		upward_edges_.resize(upward_offsets_.back());
+		downward_edges_.resize(downward_offsets_.back());
+		std::vector<size_t> upward_positions(upward_offsets_.begin(), upward_offsets_.end() - 1);
+		std::vector<size_t> downward_positions(downward_offsets_.begin(), downward_offsets_.end() - 1);
+		for (EdgeId edge_id = 0; edge_id < hierarchy_edge_count; ++edge_id)
+		{
+			const auto edge = GetHierarchyEdge(edge_id);
+			if (ranks_[edge.from] < ranks_[edge.to])
+			{
+				upward_edges_[upward_positions[edge.from]++] = { edge.to, edge.weight, edge_id };
+			}
+			else if (ranks_[edge.from] > ranks_[edge.to])
+			{
+				downward_edges_[downward_positions[edge.to]++] = { edge.from, edge.weight, edge_id };
+			}
+		}
+	}
+
+	template <typename Weight>
+	std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(VertexId from,
+		VertexId to) const
+	{
+		const size_t vertex_count = graph_.GetVertexCount();
+		if (from >= vertex_count || to >= vertex_count)
+		{
+			throw std::out_of_range("Vertex id is out of range");
+		}
+		if (from == to)
+		{
+			return RouteInfo{ WeightTraits<Weight>::FromKey(ZERO_KEY), {} };
+		}
+
+		// индекс 0 - прямой поиск от from, индекс 1 - обратный поиск от to
+		auto forward_state = states_.Acquire();
+		auto backward_state = states_.Acquire();
+		SearchState<Key>* states[2] = { &*forward_state, &*backward_state };
+		const VertexId sources[2] = { from, to };
+		for (size_t direction = 0; direction < 2; ++direction)
+		{
+			states[direction]->Reset(vertex_count);
+			states[direction]->Reach(sources[direction], ZERO_KEY, SearchState<Key>::NO_EDGE);
+			states[direction]->Push(ZERO_KEY, ZERO_KEY, sources[direction]);
+		}
+
+		std::optional<Key> best_weight;
+		VertexId meeting_vertex = from;
+		while (!states[0]->IsQueueEmpty() || !states[1]->IsQueueEmpty())
+		{
+			const size_t direction = states[1]->IsQueueEmpty()
+				|| (!states[0]->IsQueueEmpty() && !(states[1]->Top().weight < states[0]->Top().weight)) ? 0 : 1;
+			auto& state = *states[direction];
+			const auto item = state.Pop();
+			if (state.GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			// дальнейший поиск в этом направлении не улучшит найденный путь
+			if (best_weight && !(item.weight < *best_weight))
+			{
+				state.ClearQueue();
+				continue;
+			}
+			const auto& other_state = *states[1 - direction];
+			if (other_state.IsReached(item.vertex))
+			{
+				const Key candidate_weight = item.weight + other_state.GetWeight(item.vertex);
+				if (!best_weight || candidate_weight < *best_weight)
+				{
+					best_weight = candidate_weight;
+					meeting_vertex = item.vertex;
+				}
+			}
+
+			const auto& offsets = direction == 0 ? upward_offsets_ : downward_offsets_;
+			const auto& edges = direction == 0 ? upward_edges_ : downward_edges_;
+			for (size_t index = offsets[item.vertex]; index < offsets[item.vertex + 1]; ++index)
+			{
+				const NeighborEdge& edge = edges[index];
+				const Key candidate_weight = item.weight + edge.weight;
+				if (!state.IsReached(edge.vertex) || candidate_weight < state.GetWeight(edge.vertex))
+				{
+					state.Reach(edge.vertex, candidate_weight, edge.edge_id);
+					state.Push(candidate_weight, candidate_weight, edge.vertex);
+				}
+			}
+		}
+
+		if (!best_weight)
+		{
+			return std::nullopt;
+		}
+
+		std::vector<EdgeId> forward_edges;
+		for (EdgeId edge_id = states[0]->GetPrevEdge(meeting_vertex);
+			edge_id != SearchState<Key>::NO_EDGE;
+			edge_id = states[0]->GetPrevEdge(GetHierarchyEdge(edge_id).from))
+		{
+			forward_edges.push_back(edge_id);
+		}
+		std::reverse(forward_edges.begin(), forward_edges.end());
+
+		std::vector<EdgeId> edges;
+		for (const EdgeId edge_id : forward_edges)
+		{
+			UnpackEdge(edge_id, edges);
+		}
+		for (EdgeId edge_id = states[1]->GetPrevEdge(meeting_vertex);
+			edge_id != SearchState<Key>::NO_EDGE;
+			edge_id = states[1]->GetPrevEdge(GetHierarchyEdge(edge_id).to))
+		{
+			UnpackEdge(edge_id, edges);
+		}
+
+		return RouteInfo{ WeightTraits<Weight>::FromKey(*best_weight), std::move(edges) };
+	}
+
+	template <typename Weight>
+	void ContractionHierarchy<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const
+	{
+		const size_t edge_count = graph_.GetEdgeCount();
+		std::vector<EdgeId> stack{ edge_id };
+		while (!stack.empty())
+		{
+			const EdgeId current = stack.back();
+			stack.pop_back();
+			if (current < edge_count)
+			{
+				edges.push_back(current);
+				continue;
+			}
+			const Shortcut& shortcut = shortcuts_[current - edge_count];
+			stack.push_back(shortcut.second_edge);
+			stack.push_back(shortcut.first_edge);
+		}
+	}
+} // namespace graph
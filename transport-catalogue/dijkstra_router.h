@@ -0,0 +1,281 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "router.h"
+#include "search_state.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// маршрутизатор, ищущий кратчайший путь алгоритмом Дейкстры на каждый запрос:
+	// не требует предварительных вычислений, расход памяти линеен по V + E
+	template <typename Weight>
+	class DijkstraRouter
+	{
+	private:
+		using Graph = FrozenGraph<Weight>;
+		using Key = typename WeightTraits<Weight>::Key;
+
+	public:
+		using RouteInfo = typename Router<Weight>::RouteInfo;
+
+		explicit DijkstraRouter(const Graph& graph);
+
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+		// A*: potential(vertex) - нижняя оценка веса пути от vertex до to, согласованная
+		// с весами рёбер (для ребра u->v оценка u не больше веса ребра плюс оценка v)
+		template <typename Potential>
+		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const Potential& potential) const;
+
+		// маршруты из одной вершины во все targets одним деревом кратчайших путей: поиск
+		// останавливается, как только извлечены все цели. Ответ i соответствует targets[i]
+		std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+		// то же без восстановления рёбер, когда нужны только веса путей
+		std::vector<std::optional<Weight>> ComputeWeights(VertexId from, const std::vector<VertexId>& targets) const;
+
+		// вершины, достижимые из from с весом пути не больше max_weight, и веса путей до них
+		// в порядке возрастания; работа пропорциональна размеру достижимой области
+		std::vector<std::pair<VertexId, Weight>> ComputeReachable(VertexId from, const Weight& max_weight) const;
+
+	private:
+		struct ZeroPotential
+		{
+			Key operator()(VertexId) const
+			{
+				return Key{};
+			}
+		};
+
+		void CheckVertex(VertexId vertex) const;
+		void GrowTree(SearchState<Key>& state, VertexId from, const std::vector<VertexId>& targets) const;
+		std::vector<EdgeId> ExtractEdges(const SearchState<Key>& state, VertexId to) const;
+
+		static constexpr Key ZERO_KEY{};
+		const Graph& graph_;
+		mutable SearchStatePool<Key> states_;
+	};
+
+	template <typename Weight>
+	DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+		: graph_(graph)
+	{
+		for (const Key& key : graph_.GetKeys())
+		{
+			if (key < ZERO_KEY)
+			{
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+		}
+	}
+
+	template <typename Weight>
+	std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+		VertexId to) const
+	{
+		return BuildRoute(from, to, ZeroPotential{});
+	}
+
+	template <typename Weight>
+	template <typename Potential>
+	std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+		VertexId to, const Potential& potential) const
+	{
+		CheckVertex(from);
+		CheckVertex(to);
+		const size_t vertex_count = graph_.GetVertexCount();
+
+		auto state = states_.Acquire();
+		state->Reset(vertex_count);
+		state->Reach(from, ZERO_KEY, SearchState<Key>::NO_EDGE);
+		state->Push(potential(from), ZERO_KEY, from);
+		while (!state->IsQueueEmpty())
+		{
+			const auto item = state->Pop();
+			// устаревшая запись: вершина уже извлечена с меньшим весом
+			if (state->GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			if (item.vertex == to)
+			{
+				break;
+			}
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex))
+			{
+				const VertexId next_vertex = graph_.GetEdgeTarget(edge_id);
+				const Key candidate_weight = item.weight + graph_.GetEdgeKey(edge_id);
+				if (!state->IsReached(next_vertex) || candidate_weight < state->GetWeight(next_vertex))
+				{
+					state->Reach(next_vertex, candidate_weight, edge_id);
+					state->Push(candidate_weight + potential(next_vertex), candidate_weight, next_vertex);
+				}
+			}
+		}
+
+		if (!state->IsReached(to))
+		{
+			return std::nullopt;
+		}
+		return RouteInfo{ WeightTraits<Weight>::FromKey(state->GetWeight(to)), ExtractEdges(*state, to) };
+	}
+
+	template <typename Weight>
+	std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(
+		VertexId from, const std::vector<VertexId>& targets) const
+	{
+		auto state = states_.Acquire();
+		GrowTree(*state, from, targets);
+
+		std::vector<std::optional<RouteInfo>> result;
+		result.reserve(targets.size());
+		for (const VertexId to : targets)
+		{
+			if (state->IsReached(to))
+			{
+				result.push_back(RouteInfo{ WeightTraits<Weight>::FromKey(state->GetWeight(to)), ExtractEdges(*state, to) });
+			}
+			else
+			{
+				result.push_back(std::nullopt);
+			}
+		}
+		return result;
+	}
+
+	template <typename Weight>
+	std::vector<std::optional<Weight>> DijkstraRouter<Weight>::ComputeWeights(VertexId from,
+		const std::vector<VertexId>& targets) const
+	{
+		auto state = states_.Acquire();
+		GrowTree(*state, from, targets);
+
+		std::vector<std::optional<Weight>> result;
+		result.reserve(targets.size());
+		for (const VertexId to : targets)
+		{
+			if (state->IsReached(to))
+			{
+				result.push_back(WeightTraits<Weight>::FromKey(state->GetWeight(to)));
+			}
+			else
+			{
+				result.push_back(std::nullopt);
+			}
+		}
+		return result;
+	}
+
+	template <typename Weight>
+	std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::ComputeReachable(VertexId from,
+		const Weight& max_weight) const
+	{
+		CheckVertex(from);
+		const Key max_key = WeightTraits<Weight>::ToKey(max_weight);
+		std::vector<std::pair<VertexId, Weight>> result;
+		if (max_key < ZERO_KEY)
+		{
+			return result;
+		}
+
+		auto state = states_.Acquire();
+		state->Reset(graph_.GetVertexCount());
+		state->Reach(from, ZERO_KEY, SearchState<Key>::NO_EDGE);
+		state->Push(ZERO_KEY, ZERO_KEY, from);
+		while (!state->IsQueueEmpty())
+		{
+			const auto item = state->Pop();
+			if (state->GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			result.emplace_back(item.vertex, WeightTraits<Weight>::FromKey(item.weight));
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex))
+			{
+				const VertexId next_vertex = graph_.GetEdgeTarget(edge_id);
+				const Key candidate_weight = item.weight + graph_.GetEdgeKey(edge_id);
+				// вершины за пределами бюджета не попадают даже в очередь
+				if (max_key < candidate_weight)
+				{
+					continue;
+				}
+				if (!state->IsReached(next_vertex) || candidate_weight < state->GetWeight(next_vertex))
+				{
+					state->Reach(next_vertex, candidate_weight, edge_id);
+					state->Push(candidate_weight, candidate_weight, next_vertex);
+				}
+			}
+		}
+		return result;
+	}
+
+	template <typename Weight>
+	void DijkstraRouter<Weight>::CheckVertex(VertexId vertex) const
+	{
+		if (vertex >= graph_.GetVertexCount())
+		{
+			throw std::out_of_range("Vertex id is out of range");
+		}
+	}
+
+	template <typename Weight>
+	void DijkstraRouter<Weight>::GrowTree(SearchState<Key>& state, VertexId from,
+		const std::vector<VertexId>& targets) const
+	{
+		CheckVertex(from);
+		std::vector<VertexId> pending_targets = targets;
+		for (const VertexId to : pending_targets)
+		{
+			CheckVertex(to);
+		}
+		std::sort(pending_targets.begin(), pending_targets.end());
+		pending_targets.erase(std::unique(pending_targets.begin(), pending_targets.end()), pending_targets.end());
+		size_t pending_count = pending_targets.size();
+
+		state.Reset(graph_.GetVertexCount());
+		state.Reach(from, ZERO_KEY, SearchState<Key>::NO_EDGE);
+		state.Push(ZERO_KEY, ZERO_KEY, from);
+		while (!state.IsQueueEmpty() && pending_count > 0)
+		{
+			const auto item = state.Pop();
+			if (state.GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			// каждая вершина извлекается с окончательным весом ровно один раз
+			if (std::binary_search(pending_targets.begin(), pending_targets.end(), item.vertex))
+			{
+				--pending_count;
+			}
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex))
+			{
+				const VertexId next_vertex = graph_.GetEdgeTarget(edge_id);
+				const Key candidate_weight = item.weight + graph_.GetEdgeKey(edge_id);
+				if (!state.IsReached(next_vertex) || candidate_weight < state.GetWeight(next_vertex))
+				{
+					state.Reach(next_vertex, candidate_weight, edge_id);
+					state.Push(candidate_weight, candidate_weight, next_vertex);
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	std::vector<EdgeId> DijkstraRouter<Weight>::ExtractEdges(const SearchState<Key>& state, VertexId to) const
+	{
+		std::vector<EdgeId> edges;
+		for (EdgeId edge_id = state.GetPrevEdge(to);
+			edge_id != SearchState<Key>::NO_EDGE;
+			edge_id = state.GetPrevEdge(graph_.GetEdgeSource(edge_id)))
+		{
+			edges.push_back(edge_id);
+		}
+		std::reverse(edges.begin(), edges.end());
+		return edges;
+	}
+} // namespace graph
@@ -1,31 +1,42 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "geo.h"
 
 namespace transport_catalogue
 {
+	// плотные номера остановок и автобусов: справочник раздаёт их подряд в порядке добавления
+	using StopId = uint32_t;
+	using BusId = uint32_t;
+
+	// name - вид на имя в справочнике: при добавлении он копирует имя к себе, а Freeze
+	// переносит его в общий снимок
 	struct Stop
 	{
-		std::string name;
+		std::string_view name;
 		geo::Coordinates coordinates;
+		StopId id = 0;
 	};
 
+	// остановки маршрута хранит справочник: TransportCatalogue::GetBusStops
 	struct Bus
 	{
-		std::string name;
-		std::vector<const Stop*> stops;
-		bool is_roundtrip;
+		std::string_view name;
+		bool is_roundtrip = false;
+		BusId id = 0;
 	};
 
+	// статистика маршрута автобуса; name ссылается на имя автобуса в справочнике
 	struct BusInfo
 	{
-		std::string name;
-		int amount_stops;
-		int uniq_stops;
-		double route_length;
-		double curvature;
+		std::string_view name;
+		int amount_stops = 0;
+		int uniq_stops = 0;
+		double route_length = 0;
+		double curvature = 0;
 	};
 } // namespace domain
\ No newline at end of file
@@ -0,0 +1,239 @@
+#pragma once
+
+#include "graph.h"
+#include "ranges.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// Неизменяемый граф в формате CSR (compressed sparse row): рёбра упорядочены по началу,
+	// исходящие рёбра вершины v имеют номера [offsets[v], offsets[v + 1]), а концы и веса рёбер
+	// лежат в параллельных массивах. Обход соседей читает подряд идущую память, без отдельного
+	// списка на каждую вершину и без перехода от номера ребра к его записи. Ключи весов
+	// (WeightTraits) хранятся отдельно от самих весов: поиск читает только плотный массив
+	// ключей, а полный вес ребра нужен лишь при разборе найденного пути.
+	// Строится один раз по DirectedWeightedGraph; номера рёбер при этом меняются (см. MapEdgeIds)
+	template <typename Weight>
+	class FrozenGraph
+	{
+	public:
+		using Key = typename WeightTraits<Weight>::Key;
+		using IncidentEdgesRange = ranges::Range<ranges::CountingIterator<EdgeId>>;
+		using IncomingEdgesRange = ranges::Range<std::vector<uint32_t>::const_iterator>;
+
+		FrozenGraph() = default;
+		explicit FrozenGraph(const DirectedWeightedGraph<Weight>& graph);
+		// граф из готовых массивов CSR, например после десериализации
+		FrozenGraph(std::vector<EdgeId> offsets, std::vector<uint32_t> targets, std::vector<Weight> weights);
+
+		// номер, который получает каждое ребро graph в построенном по нему FrozenGraph
+		static std::vector<EdgeId> MapEdgeIds(const DirectedWeightedGraph<Weight>& graph);
+
+		size_t GetVertexCount() const;
+		size_t GetEdgeCount() const;
+		Edge<Weight> GetEdge(EdgeId edge_id) const;
+		IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+		// рёбра, входящие в вершину, для поиска против направления рёбер
+		IncomingEdgesRange GetIncomingEdges(VertexId vertex) const;
+		size_t GetOutDegree(VertexId vertex) const;
+		size_t GetInDegree(VertexId vertex) const;
+
+		// доступ к ребру без проверок для горячих циклов поиска
+		VertexId GetEdgeSource(EdgeId edge_id) const
+		{
+			return sources_[edge_id];
+		}
+		VertexId GetEdgeTarget(EdgeId edge_id) const
+		{
+			return targets_[edge_id];
+		}
+		const Key& GetEdgeKey(EdgeId edge_id) const
+		{
+			return keys_[edge_id];
+		}
+		const Weight& GetEdgeWeight(EdgeId edge_id) const
+		{
+			return weights_[edge_id];
+		}
+
+		// массивы CSR для сериализации
+		const std::vector<EdgeId>& GetOffsets() const;
+		const std::vector<uint32_t>& GetTargets() const;
+		const std::vector<Weight>& GetWeights() const;
+		const std::vector<Key>& GetKeys() const;
+
+	private:
+		void BuildIndex();
+
+		std::vector<EdgeId> offsets_{ 0 };
+		std::vector<uint32_t> targets_;
+		std::vector<Weight> weights_;
+		// ключи весов, начала рёбер и входящие рёбра выводятся из остальных массивов при построении
+		std::vector<Key> keys_;
+		std::vector<uint32_t> sources_;
+		std::vector<EdgeId> incoming_offsets_{ 0 };
+		std::vector<uint32_t> incoming_edges_;
+	};
+
+	template <typename Weight>
+	FrozenGraph<Weight>::FrozenGraph(const DirectedWeightedGraph<Weight>& graph)
+	{
+		const auto& incidence_lists = graph.GetIncidenceLists();
+		offsets_.reserve(incidence_lists.size() + 1);
+		targets_.reserve(graph.GetEdgeCount());
+		weights_.reserve(graph.GetEdgeCount());
+		for (const auto& incidence_list : incidence_lists)
+		{
+			for (const EdgeId edge_id : incidence_list)
+			{
+				const auto& edge = graph.GetEdge(edge_id);
+				targets_.push_back(static_cast<uint32_t>(edge.to));
+				weights_.push_back(edge.weight);
+			}
+			offsets_.push_back(targets_.size());
+		}
+		BuildIndex();
+	}
+
+	template <typename Weight>
+	FrozenGraph<Weight>::FrozenGraph(std::vector<EdgeId> offsets, std::vector<uint32_t> targets, std::vector<Weight> weights)
+		: offsets_(std::move(offsets))
+		, targets_(std::move(targets))
+		, weights_(std::move(weights))
+	{
+		if (offsets_.empty() || offsets_.front() != 0 || offsets_.back() != targets_.size()
+			|| weights_.size() != targets_.size() || !std::is_sorted(offsets_.begin(), offsets_.end()))
+		{
+			throw std::invalid_argument("Graph offsets should be a non-decreasing split of the edges");
+		}
+		BuildIndex();
+	}
+
+	template <typename Weight>
+	void FrozenGraph<Weight>::BuildIndex()
+	{
+		const size_t vertex_count = GetVertexCount();
+		const size_t edge_count = GetEdgeCount();
+		if (vertex_count >= std::numeric_limits<uint32_t>::max() || edge_count >= std::numeric_limits<uint32_t>::max())
+		{
+			throw std::length_error("Too many vertices or edges for the frozen graph");
+		}
+		keys_.resize(edge_count);
+		std::transform(weights_.begin(), weights_.end(), keys_.begin(), &WeightTraits<Weight>::ToKey);
+		sources_.resize(edge_count);
+		incoming_offsets_.assign(vertex_count + 1, 0);
+		for (VertexId vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			std::fill(sources_.begin() + offsets_[vertex], sources_.begin() + offsets_[vertex + 1], static_cast<uint32_t>(vertex));
+		}
+		for (const uint32_t target : targets_)
+		{
+			if (target >= vertex_count)
+			{
+				throw std::out_of_range("Edge target is out of range");
+			}
+			++incoming_offsets_[target + 1];
+		}
+		// входящие рёбра раскладываются подсчётом, внутри вершины - по возрастанию номера
+		for (VertexId vertex = 0; vertex < vertex_count; ++vertex)
+		{
+			incoming_offsets_[vertex + 1] += incoming_offsets_[vertex];
+		}
+		incoming_edges_.resize(edge_count);
+		std::vector<EdgeId> positions(incoming_offsets_.begin(), incoming_offsets_.end() - 1);
+		for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id)
+		{
+			incoming_edges_[positions[targets_[edge_id]]++] = static_cast<uint32_t>(edge_id);
+		}
+	}
+
+	template <typename Weight>
+	std::vector<EdgeId> FrozenGraph<Weight>::MapEdgeIds(const DirectedWeightedGraph<Weight>& graph)
+	{
+		// рёбра замороженного графа идут в порядке списков инцидентности
+		std::vector<EdgeId> result(graph.GetEdgeCount());
+		EdgeId frozen_edge_id = 0;
+		for (const auto& incidence_list : graph.GetIncidenceLists())
+		{
+			for (const EdgeId edge_id : incidence_list)
+			{
+				result[edge_id] = frozen_edge_id++;
+			}
+		}
+		return result;
+	}
+
+	template <typename Weight>
+	size_t FrozenGraph<Weight>::GetVertexCount() const
+	{
+		return offsets_.size() - 1;
+	}
+
+	template <typename Weight>
+	size_t FrozenGraph<Weight>::GetEdgeCount() const
+	{
+		return targets_.size();
+	}
+
+	template <typename Weight>
+	Edge<Weight> FrozenGraph<Weight>::GetEdge(EdgeId edge_id) const
+	{
+		return Edge<Weight>{ sources_.at(edge_id), targets_[edge_id], weights_[edge_id] };
+	}
+
+	template <typename Weight>
+	typename FrozenGraph<Weight>::IncidentEdgesRange FrozenGraph<Weight>::GetIncidentEdges(VertexId vertex) const
+	{
+		return IncidentEdgesRange(ranges::CountingIterator<EdgeId>(offsets_.at(vertex)),
+			ranges::CountingIterator<EdgeId>(offsets_[vertex + 1]));
+	}
+
+	template <typename Weight>
+	typename FrozenGraph<Weight>::IncomingEdgesRange FrozenGraph<Weight>::GetIncomingEdges(VertexId vertex) const
+	{
+		return IncomingEdgesRange(incoming_edges_.begin() + incoming_offsets_.at(vertex),
+			incoming_edges_.begin() + incoming_offsets_[vertex + 1]);
+	}
+
+	template <typename Weight>
+	size_t FrozenGraph<Weight>::GetOutDegree(VertexId vertex) const
+	{
+		return offsets_.at(vertex + 1) - offsets_[vertex];
+	}
+
+	template <typename Weight>
+	size_t FrozenGraph<Weight>::GetInDegree(VertexId vertex) const
+	{
+		return incoming_offsets_.at(vertex + 1) - incoming_offsets_[vertex];
+	}
+
+	template <typename Weight>
+	const std::vector<EdgeId>& FrozenGraph<Weight>::GetOffsets() const
+	{
+		return offsets_;
+	}
+
+	template <typename Weight>
+	const std::vector<uint32_t>& FrozenGraph<Weight>::GetTargets() const
+	{
+		return targets_;
+	}
+
+	template <typename Weight>
+	const std::vector<Weight>& FrozenGraph<Weight>::GetWeights() const
+	{
+		return weights_;
+	}
+
+	template <typename Weight>
+	const std::vector<typename FrozenGraph<Weight>::Key>& FrozenGraph<Weight>::GetKeys() const
+	{
+		return keys_;
+	}
+} // namespace graph
@@ -10,6 +10,23 @@ namespace graph
 	using VertexId = size_t;
 	using EdgeId = size_t;
 
+	// точка настройки типа веса для алгоритмов поиска: ключ, по которому пути складываются
+	// и сравниваются, отделён от остальных данных веса. По умолчанию ключом служит сам вес
+	template <typename Weight>
+	struct WeightTraits
+	{
+		using Key = Weight;
+
+		static Key ToKey(const Weight& weight)
+		{
+			return weight;
+		}
+		static Weight FromKey(const Key& key)
+		{
+			return key;
+		}
+	};
+
 	template <typename Weight>
 	struct Edge
 	{
@@ -0,0 +1,291 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "search_state.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// Индекс меток-хабов (2-hop labeling): у каждой вершины v есть исходящая метка - хабы,
+	// достижимые из v, с весами путей до них, и входящая - хабы, из которых достижима v.
+	// Вес кратчайшего пути s -> t равен минимуму по общим хабам исходящей метки s и входящей
+	// метки t, поэтому запрос - слияние двух отсортированных массивов без обхода графа.
+	// Метки строятся обрезанной разметкой по ориентирам (pruned landmark labeling):
+	// вершины по убыванию степени по очереди становятся хабами, и поиск из хаба не идёт
+	// дальше вершин, расстояние до которых уже покрыто более ранними хабами
+	template <typename Weight>
+	class HubLabels
+	{
+	private:
+		using Graph = FrozenGraph<Weight>;
+		using Key = typename WeightTraits<Weight>::Key;
+
+	public:
+		// метки всех вершин в одном направлении без владения данными: хабы вершины v и веса
+		// путей до них лежат в [offsets[v], offsets[v + 1]). Хаб задан своим порядковым номером,
+		// и метка отсортирована по нему
+		struct LabelsView
+		{
+			size_t vertex_count = 0;
+			const uint64_t* offsets = nullptr;
+			const uint32_t* hubs = nullptr;
+			const Key* weights = nullptr;
+		};
+
+		explicit HubLabels(const Graph& graph);
+		// использует готовые метки во внешней памяти без копирования; storage продлевает их жизнь
+		HubLabels(const Graph& graph, LabelsView out_labels, LabelsView in_labels, std::shared_ptr<const void> storage);
+
+		HubLabels(const HubLabels&) = delete;
+		HubLabels& operator=(const HubLabels&) = delete;
+
+		// вес кратчайшего пути from -> to либо пусто, если пути нет
+		std::optional<Weight> ComputeWeight(VertexId from, VertexId to) const;
+
+		const LabelsView& GetOutLabels() const;
+		const LabelsView& GetInLabels() const;
+
+	private:
+		struct Labels
+		{
+			std::vector<uint64_t> offsets;
+			std::vector<uint32_t> hubs;
+			std::vector<Key> weights;
+		};
+
+		using LabelEntries = std::vector<std::vector<std::pair<uint32_t, Key>>>;
+
+		// поиск из хаба с рангом rank по рёбрам (forward) или против них; добавляет хаб
+		// во входящие (forward) либо исходящие метки достигнутых вершин
+		void AddHub(VertexId hub, uint32_t rank, bool forward, const LabelEntries& hub_labels, LabelEntries& labels,
+			SearchState<Key>& state, std::vector<Key>& hub_weights) const;
+		static Labels Flatten(const LabelEntries& entries);
+		static LabelsView MakeView(const Labels& labels);
+		void CheckVertex(VertexId vertex) const;
+
+		static constexpr Key UNREACHABLE = std::numeric_limits<Key>::max();
+		const Graph& graph_;
+		Labels out_labels_internal_;
+		Labels in_labels_internal_;
+		LabelsView out_labels_;
+		LabelsView in_labels_;
+		std::shared_ptr<const void> storage_;
+	};
+
+	template <typename Weight>
+	HubLabels<Weight>::HubLabels(const Graph& graph)
+		: graph_(graph)
+	{
+		const size_t vertex_count = graph_.GetVertexCount();
+		if (vertex_count >= std::numeric_limits<uint32_t>::max())
+		{
+			throw std::length_error("Too many vertices for hub labels");
+		}
+		for (const Key& key : graph_.GetKeys())
+		{
+			if (key < Key{})
+			{
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+		}
+
+		// вершины с большим числом рёбер покрывают больше кратчайших путей и идут первыми
+		std::vector<VertexId> order(vertex_count);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](VertexId left, VertexId right)
+		{
+			return graph_.GetOutDegree(left) + graph_.GetInDegree(left) > graph_.GetOutDegree(right) + graph_.GetInDegree(right);
+		});
+
+		LabelEntries out_entries(vertex_count);
+		LabelEntries in_entries(vertex_count);
+		SearchState<Key> state;
+		std::vector<Key> hub_weights(vertex_count, UNREACHABLE);
+		for (uint32_t rank = 0; rank < vertex_count; ++rank)
+		{
+			AddHub(order[rank], rank, true, out_entries, in_entries, state, hub_weights);
+			AddHub(order[rank], rank, false, in_entries, out_entries, state, hub_weights);
+		}
+
+		out_labels_internal_ = Flatten(out_entries);
+		in_labels_internal_ = Flatten(in_entries);
+		out_labels_ = MakeView(out_labels_internal_);
+		in_labels_ = MakeView(in_labels_internal_);
+	}
+
+	template <typename Weight>
+	HubLabels<Weight>::HubLabels(const Graph& graph, LabelsView out_labels, LabelsView in_labels,
+		std::shared_ptr<const void> storage)
+		: graph_(graph)
+		, out_labels_(out_labels)
+		, in_labels_(in_labels)
+		, storage_(std::move(storage))
+	{
+		if (out_labels_.vertex_count != graph.GetVertexCount() || in_labels_.vertex_count != graph.GetVertexCount())
+		{
+			throw std::invalid_argument("Hub labels size should match vertex count");
+		}
+	}
+
+	template <typename Weight>
+	void HubLabels<Weight>::AddHub(VertexId hub, uint32_t rank, bool forward, const LabelEntries& hub_labels,
+		LabelEntries& labels, SearchState<Key>& state, std::vector<Key>& hub_weights) const
+	{
+		// веса от хаба до более ранних хабов (или от них до хаба) - для проверки покрытия за O(|метки|)
+		for (const auto& [hub_rank, weight] : hub_labels[hub])
+		{
+			hub_weights[hub_rank] = weight;
+		}
+
+		auto relax = [this, &state, forward](const Key& weight, EdgeId edge_id)
+		{
+			const VertexId next_vertex = forward ? graph_.GetEdgeTarget(edge_id) : graph_.GetEdgeSource(edge_id);
+			const Key candidate_weight = weight + graph_.GetEdgeKey(edge_id);
+			if (!state.IsReached(next_vertex) || candidate_weight < state.GetWeight(next_vertex))
+			{
+				state.Reach(next_vertex, candidate_weight, edge_id);
+				state.Push(candidate_weight, candidate_weight, next_vertex);
+			}
+		};
+
+		state.Reset(graph_.GetVertexCount());
+		state.Reach(hub, Key{}, SearchState<Key>::NO_EDGE);
+		state.Push(Key{}, Key{}, hub);
+		while (!state.IsQueueEmpty())
+		{
+			const auto item = state.Pop();
+			if (state.GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			// путь уже покрыт более ранним хабом: ни вершину, ни пути через неё не размечаем
+			bool is_covered = false;
+			for (const auto& [hub_rank, weight] : labels[item.vertex])
+			{
+				if (hub_weights[hub_rank] != UNREACHABLE && !(item.weight < hub_weights[hub_rank] + weight))
+				{
+					is_covered = true;
+					break;
+				}
+			}
+			if (is_covered)
+			{
+				continue;
+			}
+			labels[item.vertex].emplace_back(rank, item.weight);
+
+			if (forward)
+			{
+				for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex))
+				{
+					relax(item.weight, edge_id);
+				}
+			}
+			else
+			{
+				for (const EdgeId edge_id : graph_.GetIncomingEdges(item.vertex))
+				{
+					relax(item.weight, edge_id);
+				}
+			}
+		}
+
+		for (const auto& [hub_rank, weight] : hub_labels[hub])
+		{
+			hub_weights[hub_rank] = UNREACHABLE;
+		}
+	}
+
+	template <typename Weight>
+	typename HubLabels<Weight>::Labels HubLabels<Weight>::Flatten(const LabelEntries& entries)
+	{
+		Labels labels;
+		labels.offsets.reserve(entries.size() + 1);
+		labels.offsets.push_back(0);
+		for (const auto& vertex_entries : entries)
+		{
+			for (const auto& [hub_rank, weight] : vertex_entries)
+			{
+				labels.hubs.push_back(hub_rank);
+				labels.weights.push_back(weight);
+			}
+			labels.offsets.push_back(labels.hubs.size());
+		}
+		return labels;
+	}
+
+	template <typename Weight>
+	typename HubLabels<Weight>::LabelsView HubLabels<Weight>::MakeView(const Labels& labels)
+	{
+		return LabelsView{ labels.offsets.size() - 1, labels.offsets.data(), labels.hubs.data(), labels.weights.data() };
+	}
+
+	template <typename Weight>
+	void HubLabels<Weight>::CheckVertex(VertexId vertex) const
+	{
+		if (vertex >= out_labels_.vertex_count)
+		{
+			throw std::out_of_range("Vertex id is out of range");
+		}
+	}
+
+	template <typename Weight>
+	std::optional<Weight> HubLabels<Weight>::ComputeWeight(VertexId from, VertexId to) const
+	{
+		CheckVertex(from);
+		CheckVertex(to);
+		// слияние двух меток, отсортированных по рангу хаба
+		uint64_t out_index = out_labels_.offsets[from];
+		const uint64_t out_end = out_labels_.offsets[from + 1];
+		uint64_t in_index = in_labels_.offsets[to];
+		const uint64_t in_end = in_labels_.offsets[to + 1];
+		std::optional<Key> best_weight;
+		while (out_index < out_end && in_index < in_end)
+		{
+			const uint32_t out_hub = out_labels_.hubs[out_index];
+			const uint32_t in_hub = in_labels_.hubs[in_index];
+			if (out_hub < in_hub)
+			{
+				++out_index;
+			}
+			else if (in_hub < out_hub)
+			{
+				++in_index;
+			}
+			else
+			{
+				const Key weight = out_labels_.weights[out_index++] + in_labels_.weights[in_index++];
+				if (!best_weight || weight < *best_weight)
+				{
+					best_weight = weight;
+				}
+			}
+		}
+		if (!best_weight)
+		{
+			return std::nullopt;
+		}
+		return WeightTraits<Weight>::FromKey(*best_weight);
+	}
+
+	template <typename Weight>
+	const typename HubLabels<Weight>::LabelsView& HubLabels<Weight>::GetOutLabels() const
+	{
+		return out_labels_;
+	}
+
+	template <typename Weight>
+	const typename HubLabels<Weight>::LabelsView& HubLabels<Weight>::GetInLabels() const
+	{
+		return in_labels_;
+	}
+} // namespace graph
@@ -16,6 +16,62 @@ namespace transport_catalogue
 		LoadBaseRequestsToCatalog();
 	}
 
+	std::optional<std::vector<std::string>> JsonReader::ApplyBaseUpdates()
+	{
+		const auto& root = data_document_.GetRoot();
+		if (!root.IsDict() || !root.AsDict().count("base_requests"s) || !root.AsDict().at("base_requests"s).IsArray())
+		{
+			return std::nullopt;
+		}
+		const auto& base_requests = root.AsDict().at("base_requests"s).AsArray();
+		// сначала проверяем все запросы, чтобы не оставить справочник изменённым наполовину
+		for (const auto& base : base_requests)
+		{
+			if (!base.IsDict() || !detail_load::IsValidUpdate(base.AsDict(), transport_catalogue_))
+			{
+				return std::nullopt;
+			}
+		}
+
+		std::set<std::string> changed_buses;
+		for (const auto& base : base_requests)
+		{
+			const auto& request = base.AsDict();
+			if (request.at("type"s) == "Stop"s && request.count("road_distances"s))
+			{
+				const auto& stop_name = request.at("name"s).AsString();
+				std::vector<std::pair<std::string, int>> distances_to_stops;
+				for (const auto& [to_stop, distance] : request.at("road_distances"s).AsDict())
+				{
+					distances_to_stops.emplace_back(to_stop, distance.AsInt());
+				}
+				transport_catalogue_.SetDistance(stop_name, distances_to_stops);
+				for (const BusId bus_id : transport_catalogue_.GetStopBusIds(transport_catalogue_.GetStopId(stop_name)))
+				{
+					changed_buses.emplace(transport_catalogue_.GetBus(bus_id).name);
+				}
+			}
+		}
+		for (const auto& base : base_requests)
+		{
+			const auto& request = base.AsDict();
+			if (request.at("type"s) == "Bus"s)
+			{
+				const auto& bus_name = request.at("name"s).AsString();
+				transport_catalogue_.RemoveBus(bus_name);
+				if (!request.count("removed"s) || !request.at("removed"s).AsBool())
+				{
+					ReadBus(request);
+					const auto& [name, is_roundtrip, bus_stops] = request_buses_.back();
+					transport_catalogue_.AddBus(name, is_roundtrip, bus_stops);
+				}
+				changed_buses.insert(bus_name);
+			}
+		}
+		transport_catalogue_.Freeze();
+		return std::vector<std::string>(changed_buses.begin(), changed_buses.end());
+	}
+
 	void JsonReader::ReadBaseRequests()
 	{
 		const auto& base_requests = ((data_document_.GetRoot()).AsDict()).at("base_requests"s);
@@ -81,20 +137,29 @@ namespace transport_catalogue
 		{
 			transport_catalogue_.AddBus(bus_name, is_roundtrip, bus_stops);
 		}
+		transport_catalogue_.Freeze();
 	}
 
-	void JsonReader::GenerateOutput(const RenderSettings& render_settings, TransportRouter& router)
+	void JsonReader::GenerateOutput(const RenderSettings& render_settings, TransportRouter* router)
 	{
 		std::ostream& out = std::cout;
 
 		auto& requests = data_document_.GetRoot().AsDict().at("stat_requests"s);
 		if (requests.IsArray())
 		{
+			const auto routes = router ? BuildRoutes(requests.AsArray(), *router)
+				: std::vector<std::optional<TransportRouter::TransportRoute>>(requests.AsArray().size());
 			json::Array answers;
-			for (const auto& request : requests.AsArray())
+			for (size_t i = 0; i < requests.AsArray().size(); ++i)
 			{
+				const auto& request = requests.AsArray()[i];
 				const std::string& type = request.AsDict().at("type"s).AsString();
-				if (type == "Bus"s)
+				const bool is_routing_request = type == "Route"s || type == "DurationMatrix"s || type == "Isochrone"s;
+				if (is_routing_request && !router)
+				{
+					OutputRoutingUnavailable(request, answers);
+				}
+				else if (type == "Bus"s)
 				{
 					OutputBusInfo(request, answers);
 				}
@@ -106,28 +171,52 @@ namespace transport_catalogue
 				{
 					RenderMap(request, answers, render_settings);
 				}
+				else if (type == "Route"s && IsParetoRequest(request))
+				{
+					OutputParetoRoutes(request, answers, *router);
+				}
+				else if (type == "Route"s && IsAlternativesRequest(request))
+				{
+					OutputAlternativeRoutes(request, answers, *router);
+				}
 				else if (type == "Route"s)
 				{
-					OutputRouteInfo(request, answers, router);
+					OutputRouteInfo(request, answers, routes[i], router->GetSettings().wait_time);
+				}
+				else if (type == "DurationMatrix"s)
+				{
+					OutputDurationMatrix(request, answers, *router);
+				}
+				else if (type == "Isochrone"s)
+				{
+					OutputIsochrone(request, answers, *router, render_settings);
 				}
 			}
 			json::Print(json::Document{ answers }, out);
 		}
 	}
 
+	void JsonReader::OutputRoutingUnavailable(const json::Node& request, json::Array& result) const
+	{
+		result.emplace_back(json::Builder{}.StartDict().
+			Key("error_message"s).Value("routing is not available"s).
+			Key("request_id"s).Value(request.AsDict().at("id"s).AsInt()).
+			EndDict().Build());
+	}
+
 	void JsonReader::OutputBusInfo(const json::Node& request, json::Array& result) const
 	{
 		const std::string& bus_name = request.AsDict().at("name"s).AsString();
 		int id = request.AsDict().at("id"s).AsInt();
-		auto bus_info = transport_catalogue_.GetBusInfo(bus_name);
-		if (bus_info.has_value())
+		const BusInfo* bus_info = transport_catalogue_.GetBusInfo(bus_name);
+		if (bus_info != nullptr)
 		{
 			json::Node bus_output =
 				json::Builder{}.StartDict().
-				Key("curvature"s).Value(bus_info.value().curvature).
-				Key("route_length"s).Value(bus_info.value().route_length).
-				Key("stop_count"s).Value(bus_info.value().amount_stops).
-				Key("unique_stop_count"s).Value(bus_info.value().uniq_stops).
+				Key("curvature"s).Value(bus_info->curvature).
+				Key("route_length"s).Value(bus_info->route_length).
+				Key("stop_count"s).Value(bus_info->amount_stops).
+				Key("unique_stop_count"s).Value(bus_info->uniq_stops).
 				Key("request_id"s).Value(id).
 				EndDict().Build().AsDict();
 			result.emplace_back(bus_output);
@@ -160,9 +249,11 @@ namespace transport_catalogue
 		}
 		else
 		{
-			auto stop_buses = transport_catalogue_.GetStopBuses(stop_name);
 			json::Array buses;
-			std::copy(stop_buses.begin(), stop_buses.end(), std::back_inserter(buses));
+			for (const std::string_view bus_name : transport_catalogue_.GetStopBuses(stop_name))
+			{
+				buses.emplace_back(std::string(bus_name));
+			}
 			json::Node stop_output = json::Builder{}.StartDict().
 				Key("buses"s).Value(buses).
 				Key("request_id"s).Value(id).
@@ -174,14 +265,11 @@ namespace transport_catalogue
 	void JsonReader::RenderMap(const json::Node& request, json::Array& result, const RenderSettings& render_settings) const
 	{
 		int id = request.AsDict().at("id"s).AsInt();
-		const auto& buses = transport_catalogue_.GetBusnameToBus();
-		const auto& stops = transport_catalogue_.GetStopnameToStop();
-		const auto& stop_buses = transport_catalogue_.GetStopnameToBusnames();
 		std::ostringstream out;
 
 		MapRenderer renderer;
 		renderer.SetSettings(render_settings);
-		renderer.RenderMap(buses, stops, stop_buses).Render(out);
+		renderer.RenderMap(transport_catalogue_).Render(out);
 		json::Node answer_map =
 			json::Builder{}.StartDict().
 			Key("map"s).Value(out.str()).
@@ -190,13 +278,142 @@ namespace transport_catalogue
 		result.emplace_back(answer_map);
 	}
 
-	void JsonReader::OutputRouteInfo(const json::Node& request, json::Array& result, TransportRouter& router) const
+	std::vector<std::optional<TransportRouter::TransportRoute>> JsonReader::BuildRoutes(const json::Array& requests,
+		TransportRouter& router) const
+	{
+		// индексы запросов и остановки прибытия для каждой остановки отправления
+		std::unordered_map<std::string_view, std::pair<std::vector<size_t>, std::vector<std::string>>> requests_by_from;
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			const auto& request = requests[i].AsDict();
+			if (request.at("type"s).AsString() == "Route"s && !IsParetoRequest(requests[i]) && !IsAlternativesRequest(requests[i]))
+			{
+				auto& [indices, to] = requests_by_from[request.at("from"s).AsString()];
+				indices.push_back(i);
+				to.push_back(request.at("to"s).AsString());
+			}
+		}
+
+		std::vector<std::optional<TransportRouter::TransportRoute>> result(requests.size());
+		for (const auto& [from, batch] : requests_by_from)
+		{
+			const auto& [indices, to] = batch;
+			auto routes = router.BuildRoutes(std::string(from), to);
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				result[indices[i]] = std::move(routes[i]);
+			}
+		}
+		return result;
+	}
+
+	bool JsonReader::IsParetoRequest(const json::Node& request)
+	{
+		const auto& dict = request.AsDict();
+		return dict.count("pareto"s) && dict.at("pareto"s).IsBool() && dict.at("pareto"s).AsBool();
+	}
+
+	bool JsonReader::IsAlternativesRequest(const json::Node& request)
+	{
+		const auto& dict = request.AsDict();
+		return dict.count("alternatives"s) && dict.at("alternatives"s).IsInt();
+	}
+
+	void JsonReader::OutputDurationMatrix(const json::Node& request, json::Array& result, TransportRouter& router) const
+	{
+		int id = request.AsDict().at("id"s).AsInt();
+		bool are_stops_found = true;
+		auto read_stops = [this, &request, &are_stops_found](const std::string& key)
+		{
+			std::vector<std::string> stops;
+			for (const auto& stop : request.AsDict().at(key).AsArray())
+			{
+				are_stops_found = are_stops_found && transport_catalogue_.FindStop(stop.AsString()) != nullptr;
+				stops.push_back(stop.AsString());
+			}
+			return stops;
+		};
+		const auto from = read_stops("from"s);
+		const auto to = read_stops("to"s);
+		if (!are_stops_found)
+		{
+			json::Node error_message =
+				json::Builder{}.StartDict().
+				Key("request_id"s).Value(id).
+				Key("error_message"s).Value("not found"s).
+				EndDict().Build().AsDict();
+			result.emplace_back(error_message);
+			return;
+		}
+
+		json::Array durations;
+		for (const auto& row : router.ComputeDurationMatrix(from, to))
+		{
+			json::Array durations_row;
+			for (const auto& duration : row)
+			{
+				durations_row.push_back(duration ? json::Node(*duration) : json::Node(nullptr));
+			}
+			durations.push_back(std::move(durations_row));
+		}
+		json::Node matrix_output =
+			json::Builder{}.StartDict().
+			Key("request_id"s).Value(id).
+			Key("durations"s).Value(std::move(durations)).
+			EndDict().Build().AsDict();
+		result.emplace_back(matrix_output);
+	}
+
+	void JsonReader::OutputIsochrone(const json::Node& request, json::Array& result, TransportRouter& router,
+		const RenderSettings& render_settings) const
 	{
 		int id = request.AsDict().at("id"s).AsInt();
 		const auto& from = request.AsDict().at("from"s).AsString();
-		const auto& to = request.AsDict().at("to"s).AsString();
+		const double max_time = request.AsDict().at("max_time"s).AsDouble();
+		const bool is_render_requested = request.AsDict().count("render"s) && request.AsDict().at("render"s).AsBool();
+		if (transport_catalogue_.FindStop(from) == nullptr)
+		{
+			json::Node error_message =
+				json::Builder{}.StartDict().
+				Key("request_id"s).Value(id).
+				Key("error_message"s).Value("not found"s).
+				EndDict().Build().AsDict();
+			result.emplace_back(error_message);
+			return;
+		}
 
-		auto route = router.BuildRoute(from, to);
+		json::Array stops;
+		std::unordered_set<std::string_view> reachable_stops;
+		for (const auto& [stop_name, time] : router.ComputeIsochrone(from, max_time))
+		{
+			stops.push_back(
+				json::Builder{}.StartDict().
+				Key("stop_name"s).Value(std::string(stop_name)).
+				Key("time"s).Value(time).
+				EndDict().Build().AsDict());
+			reachable_stops.insert(stop_name);
+		}
+
+		json::Dict isochrone_output =
+			json::Builder{}.StartDict().
+			Key("request_id"s).Value(id).
+			Key("stops"s).Value(stops).
+			EndDict().Build().AsDict();
+		if (is_render_requested)
+		{
+			std::ostringstream out;
+			MapRenderer renderer;
+			renderer.SetSettings(render_settings);
+			renderer.RenderReachableStops(transport_catalogue_, reachable_stops).Render(out);
+			isochrone_output.emplace("map"s, out.str());
+		}
+		result.emplace_back(isochrone_output);
+	}
+
+	void JsonReader::OutputRouteInfo(const json::Node& request, json::Array& result,
+		const std::optional<TransportRouter::TransportRoute>& route, int wait_time) const
+	{
+		int id = request.AsDict().at("id"s).AsInt();
 
 		if (!route.has_value())
 		{
@@ -210,9 +427,102 @@ namespace transport_catalogue
 		}
 
 		double total_time = 0;
-		int wait_time = router.GetSettings().wait_time;
+		json::Array items = RouteItems(route.value(), wait_time, total_time);
+		json::Node route_output =
+			json::Builder{}.StartDict().
+			Key("request_id"s).Value(id).
+			Key("total_time"s).Value(total_time).
+			Key("items"s).Value(items).
+			EndDict().Build().AsDict();
+		result.emplace_back(route_output);
+	}
+
+	void JsonReader::OutputParetoRoutes(const json::Node& request, json::Array& result, TransportRouter& router) const
+	{
+		int id = request.AsDict().at("id"s).AsInt();
+		const auto& from = request.AsDict().at("from"s).AsString();
+		const auto& to = request.AsDict().at("to"s).AsString();
+		size_t max_boardings = PARETO_MAX_BOARDINGS;
+		if (request.AsDict().count("max_boardings"s) && request.AsDict().at("max_boardings"s).IsInt())
+		{
+			max_boardings = static_cast<size_t>(std::max(request.AsDict().at("max_boardings"s).AsInt(), 0));
+		}
+
+		auto routes = router.BuildParetoRoutes(from, to, max_boardings);
+		if (routes.empty())
+		{
+			json::Node error_message =
+				json::Builder{}.StartDict().
+				Key("request_id"s).Value(id).
+				Key("error_message"s).Value("not found"s).
+				EndDict().Build().AsDict();
+			result.emplace_back(error_message);
+			return;
+		}
+
+		json::Array routes_output;
+		for (const auto& route : routes)
+		{
+			double total_time = 0;
+			json::Array items = RouteItems(route, router.GetSettings().wait_time, total_time);
+			routes_output.push_back(
+				json::Builder{}.StartDict().
+				Key("total_time"s).Value(total_time).
+				Key("boardings"s).Value(static_cast<int>(route.size())).
+				Key("items"s).Value(items).
+				EndDict().Build().AsDict());
+		}
+		json::Node pareto_output =
+			json::Builder{}.StartDict().
+			Key("request_id"s).Value(id).
+			Key("routes"s).Value(routes_output).
+			EndDict().Build().AsDict();
+		result.emplace_back(pareto_output);
+	}
+
+	void JsonReader::OutputAlternativeRoutes(const json::Node& request, json::Array& result, TransportRouter& router) const
+	{
+		int id = request.AsDict().at("id"s).AsInt();
+		const auto& from = request.AsDict().at("from"s).AsString();
+		const auto& to = request.AsDict().at("to"s).AsString();
+		const int alternatives = request.AsDict().at("alternatives"s).AsInt();
+		const size_t count = std::min(static_cast<size_t>(std::max(alternatives, 1)), MAX_ALTERNATIVE_ROUTES);
+
+		auto routes = router.BuildAlternativeRoutes(from, to, count);
+		if (routes.empty())
+		{
+			json::Node error_message =
+				json::Builder{}.StartDict().
+				Key("request_id"s).Value(id).
+				Key("error_message"s).Value("not found"s).
+				EndDict().Build().AsDict();
+			result.emplace_back(error_message);
+			return;
+		}
+
+		json::Array routes_output;
+		for (const auto& route : routes)
+		{
+			double total_time = 0;
+			json::Array items = RouteItems(route, router.GetSettings().wait_time, total_time);
+			routes_output.push_back(
+				json::Builder{}.StartDict().
+				Key("total_time"s).Value(total_time).
+				Key("items"s).Value(items).
+				EndDict().Build().AsDict());
+		}
+		json::Node alternatives_output =
+			json::Builder{}.StartDict().
+			Key("request_id"s).Value(id).
+			Key("routes"s).Value(routes_output).
+			EndDict().Build().AsDict();
+		result.emplace_back(alternatives_output);
+	}
+
+	json::Array JsonReader::RouteItems(const TransportRouter::TransportRoute& route, int wait_time, double& total_time) const
+	{
 		json::Array items;
-		for (const auto& edge : route.value())
+		for (const auto& edge : route)
 		{
 			total_time += edge.total_time;
 			json::Dict wait_elem =
@@ -231,13 +541,7 @@ namespace transport_catalogue
 			items.push_back(wait_elem);
 			items.push_back(ride_elem);
 		}
-		json::Node route_output =
-			json::Builder{}.StartDict().
-			Key("request_id"s).Value(id).
-			Key("total_time"s).Value(total_time).
-			Key("items"s).Value(items).
-			EndDict().Build().AsDict();
-		result.emplace_back(route_output);
+		return items;
 	}
 
 	std::optional<RenderSettings> JsonReader::LoadRenderSettings() const
@@ -255,7 +559,12 @@ namespace transport_catalogue
 
 	std::optional<RoutingSettings> JsonReader::LoadRoutingSettings() const
 	{
-		auto& routing_settings = data_document_.GetRoot().AsDict().at("routing_settings"s).AsDict();
+		const auto& root = data_document_.GetRoot();
+		if (!root.IsDict() || !root.AsDict().count("routing_settings"s) || !root.AsDict().at("routing_settings"s).IsDict())
+		{
+			return std::nullopt;
+		}
+		auto& routing_settings = root.AsDict().at("routing_settings"s).AsDict();
 		if (routing_settings.count("bus_wait_time"s) && routing_settings.at("bus_wait_time"s).IsInt()
 			&&
 			routing_settings.count("bus_velocity"s) && routing_settings.at("bus_velocity"s).IsInt())
@@ -263,6 +572,63 @@ namespace transport_catalogue
 			RoutingSettings result;
 			result.wait_time = routing_settings.at("bus_wait_time"s).AsInt();
 			result.velocity = routing_settings.at("bus_velocity"s).AsDouble() * KMH_TO_MMIN;
+			if (routing_settings.count("router"s) && routing_settings.at("router"s).IsString())
+			{
+				const auto& name = routing_settings.at("router"s).AsString();
+				auto router_type = detail_load::RouterTypeFromString(name);
+				if (!router_type)
+				{
+					throw std::invalid_argument("unknown router \""s + name + "\""s);
+				}
+				result.router_type = *router_type;
+			}
+			if (routing_settings.count("graph_model"s) && routing_settings.at("graph_model"s).IsString())
+			{
+				const auto& name = routing_settings.at("graph_model"s).AsString();
+				auto graph_model = detail_load::GraphModelFromString(name);
+				if (!graph_model)
+				{
+					throw std::invalid_argument("unknown graph_model \""s + name + "\""s);
+				}
+				result.graph_model = *graph_model;
+			}
+			if (routing_settings.count("landmarks_count"s) && routing_settings.at("landmarks_count"s).IsInt())
+			{
+				result.landmarks_count = routing_settings.at("landmarks_count"s).AsInt();
+			}
+			if (routing_settings.count("route_cache_capacity"s) && routing_settings.at("route_cache_capacity"s).IsInt())
+			{
+				result.route_cache_capacity = routing_settings.at("route_cache_capacity"s).AsInt();
+			}
+			if (routing_settings.count("hub_labels"s) && routing_settings.at("hub_labels"s).IsBool())
+			{
+				result.hub_labels = routing_settings.at("hub_labels"s).AsBool();
+			}
+			if (routing_settings.count("all_pairs_method"s) && routing_settings.at("all_pairs_method"s).IsString())
+			{
+				const auto& name = routing_settings.at("all_pairs_method"s).AsString();
+				auto method = detail_load::PrecomputeMethodFromString(name);
+				if (!method)
+				{
+					throw std::invalid_argument("unknown all_pairs_method \""s + name + "\""s);
+				}
+				result.all_pairs_method = *method;
+			}
+			if (routing_settings.count("hot_stops"s) && routing_settings.at("hot_stops"s).IsArray())
+			{
+				for (const auto& stop_name : routing_settings.at("hot_stops"s).AsArray())
+				{
+					if (stop_name.IsString())
+					{
+						result.hot_stops.push_back(stop_name.AsString());
+					}
+				}
+			}
+			if (routing_settings.count("hot_stops_log"s) && routing_settings.at("hot_stops_log"s).IsDict())
+			{
+				auto hot_stops = detail_load::HotStopsFromLog(routing_settings.at("hot_stops_log"s).AsDict());
+				result.hot_stops.insert(result.hot_stops.end(), hot_stops.begin(), hot_stops.end());
+			}
 			return result;
 		}
 		return std::nullopt;
@@ -343,6 +709,177 @@ namespace transport_catalogue
 			return result;
 		}
 
+		std::optional<RouterType> RouterTypeFromString(const std::string& name)
+		{
+			if (name == "all_pairs"s)
+			{
+				return RouterType::ALL_PAIRS;
+			}
+			if (name == "dijkstra"s)
+			{
+				return RouterType::DIJKSTRA;
+			}
+			if (name == "contraction_hierarchy"s)
+			{
+				return RouterType::CONTRACTION_HIERARCHY;
+			}
+			if (name == "a_star"s)
+			{
+				return RouterType::A_STAR;
+			}
+			if (name == "alt"s)
+			{
+				return RouterType::ALT;
+			}
+			if (name == "raptor"s)
+			{
+				return RouterType::RAPTOR;
+			}
+			return std::nullopt;
+		}
+
+		std::optional<GraphModel> GraphModelFromString(const std::string& name)
+		{
+			if (name == "complete"s)
+			{
+				return GraphModel::COMPLETE;
+			}
+			if (name == "transfer"s)
+			{
+				return GraphModel::TRANSFER;
+			}
+			return std::nullopt;
+		}
+
+		bool IsValidUpdate(const json::Dict& request, const TransportCatalogue& catalogue)
+		{
+			if (!request.count("type"s) || !request.count("name"s) || !request.at("name"s).IsString())
+			{
+				return false;
+			}
+			const auto& name = request.at("name"s).AsString();
+			if (request.at("type"s) == "Stop"s)
+			{
+				// новые остановки меняют набор вершин графа, для них нужен полный make_base
+				const Stop* stop = catalogue.FindStop(name);
+				if (!stop)
+				{
+					return false;
+				}
+				// от координат зависят проекция карты, длины маршрутов и оценки A*: их меняет
+				// только make_base. Повтор прежних координат допустим
+				const auto is_changed = [&request](const std::string& key, double value)
+				{
+					return request.count(key) && (!request.at(key).IsDouble() || request.at(key).AsDouble() != value);
+				};
+				if (is_changed("latitude"s, stop->coordinates.lat) || is_changed("longitude"s, stop->coordinates.lng))
+				{
+					std::cerr << "Stop \""s << name << "\": coordinates can't be changed by update_base, use make_base"s << std::endl;
+					return false;
+				}
+				if (!request.count("road_distances"s))
+				{
+					return true;
+				}
+				if (!request.at("road_distances"s).IsDict())
+				{
+					return false;
+				}
+				for (const auto& [to_stop, distance] : request.at("road_distances"s).AsDict())
+				{
+					if (!catalogue.FindStop(to_stop) || !distance.IsInt())
+					{
+						return false;
+					}
+				}
+				return true;
+			}
+			if (request.at("type"s) == "Bus"s)
+			{
+				if (request.count("removed"s) && request.at("removed"s).IsBool() && request.at("removed"s).AsBool())
+				{
+					return catalogue.FindBus(name) != nullptr;
+				}
+				if (!request.count("is_roundtrip"s) || !request.at("is_roundtrip"s).IsBool()
+					|| !request.count("stops"s) || !request.at("stops"s).IsArray())
+				{
+					return false;
+				}
+				const auto& stops = request.at("stops"s).AsArray();
+				return std::all_of(stops.begin(), stops.end(), [&catalogue](const json::Node& stop)
+				{
+					return stop.IsString() && catalogue.FindStop(stop.AsString()) != nullptr;
+				});
+			}
+			return false;
+		}
+
+		std::optional<graph::PrecomputeMethod> PrecomputeMethodFromString(const std::string& name)
+		{
+			if (name == "floyd_warshall"s)
+			{
+				return graph::PrecomputeMethod::FLOYD_WARSHALL;
+			}
+			if (name == "dijkstra"s)
+			{
+				return graph::PrecomputeMethod::DIJKSTRA;
+			}
+			return std::nullopt;
+		}
+
+		std::vector<std::string> HotStopsFromLog(const json::Dict& log_settings)
+		{
+			if (!log_settings.count("file"s) || !log_settings.at("file"s).IsString()
+				|| !log_settings.count("count"s) || !log_settings.at("count"s).IsInt())
+			{
+				throw std::invalid_argument("hot_stops_log needs string \"file\" and integer \"count\""s);
+			}
+			const std::string& path = log_settings.at("file"s).AsString();
+			std::ifstream log_file(path);
+			if (!log_file.is_open())
+			{
+				throw std::invalid_argument("can't open hot_stops_log \""s + path + "\""s);
+			}
+			std::optional<json::Document> log;
+			try
+			{
+				log = json::Load(log_file);
+			}
+			catch (const json::ParsingError& error)
+			{
+				throw std::invalid_argument("can't parse hot_stops_log \""s + path + "\": "s + error.what());
+			}
+			if (!log->GetRoot().IsDict() || !log->GetRoot().AsDict().count("stat_requests"s)
+				|| !log->GetRoot().AsDict().at("stat_requests"s).IsArray())
+			{
+				throw std::invalid_argument("hot_stops_log \""s + path + "\" has no stat_requests array"s);
+			}
+
+			// частота каждой остановки как отправления в запросах Route
+			std::unordered_map<std::string, size_t> frequencies;
+			for (const auto& request : log->GetRoot().AsDict().at("stat_requests"s).AsArray())
+			{
+				if (request.IsDict() && request.AsDict().count("type"s) && request.AsDict().at("type"s) == "Route"s
+					&& request.AsDict().count("from"s) && request.AsDict().at("from"s).IsString())
+				{
+					++frequencies[request.AsDict().at("from"s).AsString()];
+				}
+			}
+			std::vector<std::pair<std::string, size_t>> ranked(frequencies.begin(), frequencies.end());
+			std::sort(ranked.begin(), ranked.end(), [](const auto& left, const auto& right)
+			{
+				return left.second != right.second ? left.second > right.second : left.first < right.first;
+			});
+
+			const size_t count = static_cast<size_t>(std::max(log_settings.at("count"s).AsInt(), 0));
+			std::vector<std::string> result;
+			for (size_t i = 0; i < std::min(count, ranked.size()); ++i)
+			{
+				result.push_back(std::move(ranked[i].first));
+			}
+			return result;
+		}
+
 		svg::Point Offset(const json::Array& offset)
 		{
 			svg::Point result;
@@ -9,13 +9,24 @@
 
 #include "svg.h"
 #include <iostream>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <deque>
+#include <fstream>
 #include <sstream>
+#include <stdexcept>
 
 namespace transport_catalogue
 {
+	// ограничение числа посадок в вариантах маршрута по умолчанию
+	constexpr static size_t PARETO_MAX_BOARDINGS = 8;
+	// наибольшее число альтернативных маршрутов в ответе на один запрос
+	constexpr static size_t MAX_ALTERNATIVE_ROUTES = 16;
+
 	class JsonReader final
 	{
 	public:
@@ -23,9 +34,16 @@ namespace transport_catalogue
 		explicit JsonReader(TransportCatalogue& transport_catalogue, std::istream& input_stream);
 
 		void ReadRequests(); //интерйфейс для отправки запросов к каталогу
-		void GenerateOutput(const RenderSettings& render_settings, TransportRouter& router); // формирует и возвращает ответы на запросы
+		// применяет base_requests режима update_base: автобусы добавляются, заменяются или удаляются
+		// ("removed": true), у существующих остановок меняются road_distances; новые координаты
+		// остановок отклоняются. Возвращает имена
+		// затронутых автобусов; при ошибке во входных данных - пусто, и справочник не меняется
+		std::optional<std::vector<std::string>> ApplyBaseUpdates();
+		// формирует и возвращает ответы на запросы; без router запросы маршрутов получают сообщение об ошибке
+		void GenerateOutput(const RenderSettings& render_settings, TransportRouter* router);
 		std::optional<RenderSettings> LoadRenderSettings() const;
 		std::optional<serialize::Serializator::Settings> LoadSerializeSettings() const;
+		// std::invalid_argument при неизвестном значении перечисления в настройках
 		std::optional<RoutingSettings> LoadRoutingSettings() const;
 	private:
 		TransportCatalogue& transport_catalogue_;
@@ -40,16 +58,41 @@ namespace transport_catalogue
 
 		void LoadBaseRequestsToCatalog(); // загрузка данных из очереди запросов в каталог
 
+		void OutputRoutingUnavailable(const json::Node& request, json::Array& result) const; // ответ на запрос маршрута без маршрутизатора
 		void OutputBusInfo(const json::Node& request, json::Array& result) const; // ответ на запрос инфромации о маршруте
 		void OutputStopInfo(const json::Node& request, json::Array& result) const; // ответ на запрос инфромации об остановке   
 		void RenderMap(const json::Node& request, json::Array& result, const RenderSettings& render_settings) const; // ответ на запрос построения карты маршрутов
-		void OutputRouteInfo(const json::Node& request, json::Array& result, TransportRouter& router) const;
+		void OutputRouteInfo(const json::Node& request, json::Array& result,
+			const std::optional<TransportRouter::TransportRoute>& route, int wait_time) const;
+		void OutputDurationMatrix(const json::Node& request, json::Array& result, TransportRouter& router) const; // ответ на запрос матрицы времён в пути
+		void OutputParetoRoutes(const json::Node& request, json::Array& result, TransportRouter& router) const; // варианты маршрута по времени и числу посадок
+		void OutputAlternativeRoutes(const json::Node& request, json::Array& result, TransportRouter& router) const; // k лучших маршрутов по времени в пути
+		void OutputIsochrone(const json::Node& request, json::Array& result, TransportRouter& router,
+			const RenderSettings& render_settings) const; // ответ на запрос зоны доступности от остановки
+		json::Array RouteItems(const TransportRouter::TransportRoute& route, int wait_time, double& total_time) const; // элементы маршрута, total_time накапливает время в пути
+		static bool IsParetoRequest(const json::Node& request); // запрос Route с "pareto": true
+		static bool IsAlternativesRequest(const json::Node& request); // запрос Route с числом маршрутов "alternatives"
+
+		// маршруты для всех запросов Route по их индексам; запросы с общей остановкой отправления считаются одним пакетом
+		std::vector<std::optional<TransportRouter::TransportRoute>> BuildRoutes(const json::Array& requests, TransportRouter& router) const;
 	};
 
 	namespace detail_load
 	{
 		RenderSettings Settings(const json::Dict& data); // формирует настройки рендеринга
 
+		std::optional<RouterType> RouterTypeFromString(const std::string& name); // тип маршрутизатора по имени из настроек
+
+		std::optional<GraphModel> GraphModelFromString(const std::string& name); // модель графа по имени из настроек
+
+		std::optional<graph::PrecomputeMethod> PrecomputeMethodFromString(const std::string& name); // способ предрасчёта ALL_PAIRS по имени
+
+		bool IsValidUpdate(const json::Dict& request, const TransportCatalogue& catalogue); // запрос update_base применим к справочнику
+
+		// самые частые остановки отправления в журнале запросов; std::invalid_argument, если журнал
+		// не открывается, не разбирается или не содержит stat_requests
+		std::vector<std::string> HotStopsFromLog(const json::Dict& log_settings);
+
 		svg::Point Offset(const json::Array& offset); // считывает пару значений (offset) из ноды
 
 		svg::Color Color(const json::Node& node); // считывает значение цвета из ноды
@@ -0,0 +1,345 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "router.h"
+#include "search_state.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// k кратчайших путей без повторения вершин алгоритмом Йена: очередной путь - лучший из кандидатов,
+	// которые совпадают с уже найденным путём до вершины ответвления, а дальше идут в обход
+	// продолжений найденных путей с тем же началом и не заходят в вершины общего начала.
+	// Поиск ответвления направляется точными весами путей до цели в полном графе: обратное дерево
+	// кратчайших путей строится один раз на запрос и даёт согласованную оценку и при запретах.
+	// Если путь дерева из извлечённой вершины не задевает запретов, он и дописывается к ответвлению,
+	// поэтому большинство ответвлений находится за несколько извлечений из очереди
+	template <typename Weight>
+	class KShortestPaths
+	{
+	private:
+		using Graph = FrozenGraph<Weight>;
+		using Key = typename WeightTraits<Weight>::Key;
+
+	public:
+		using RouteInfo = typename Router<Weight>::RouteInfo;
+
+		// отбор путей для ответа; вызывается для путей по порядку, может помнить принятые
+		using PathFilter = std::function<bool(const std::vector<EdgeId>& edges)>;
+
+		explicit KShortestPaths(const Graph& graph);
+
+		// до count путей from -> to в порядке возрастания веса; пусто, если пути нет.
+		// С filter в ответ входят только принятые им пути; отвергнутые не выдаются, но от них,
+		// как и от принятых, ищутся ответвления. Всего просматривается не более max_paths путей
+		std::vector<RouteInfo> BuildRoutes(VertexId from, VertexId to, size_t count, const PathFilter& filter = nullptr,
+			size_t max_paths = std::numeric_limits<size_t>::max()) const;
+
+	private:
+		// состояние одного запроса; переиспользуется всеми поисками ответвлений запроса
+		// и следующими запросами
+		struct QueryState
+		{
+			// обратное дерево: вес пути до цели и первое ребро этого пути
+			SearchState<Key> tree;
+			SearchState<Key> spur;
+			// метки запретов текущего ответвления, по тому же принципу, что и в SearchState
+			std::vector<uint32_t> banned_vertices;
+			std::vector<uint32_t> banned_edges;
+			uint32_t ban_stamp = 0;
+			// метки вершин при проверке склеенного пути на повторы
+			std::vector<uint32_t> path_vertices;
+			uint32_t path_stamp = 0;
+		};
+
+		// путь-кандидат; порядок - по весу, затем по рёбрам, чтобы ответ был детерминированным
+		using Path = std::pair<Key, std::vector<EdgeId>>;
+
+		void CheckVertex(VertexId vertex) const;
+		void GrowReverseTree(QueryState& state, VertexId to) const;
+		void ResetBans(QueryState& state) const;
+		// кратчайший путь из from до корня обратного дерева в обход запретов; рёбра дописываются в edges
+		bool FindSpur(QueryState& state, VertexId from, std::vector<EdgeId>& edges) const;
+		// дописывает к edges путь дерева из vertex, если он обходит запреты и не повторяет вершин
+		bool AppendTreePath(QueryState& state, VertexId from, VertexId vertex, std::vector<EdgeId>& edges) const;
+		Key ComputeWeight(const std::vector<EdgeId>& edges) const;
+
+		static constexpr Key ZERO_KEY{};
+		const Graph& graph_;
+		mutable StatePool<QueryState> states_;
+	};
+
+	template <typename Weight>
+	KShortestPaths<Weight>::KShortestPaths(const Graph& graph)
+		: graph_(graph)
+	{
+		for (const Key& key : graph_.GetKeys())
+		{
+			if (key < ZERO_KEY)
+			{
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+		}
+	}
+
+	template <typename Weight>
+	std::vector<typename KShortestPaths<Weight>::RouteInfo> KShortestPaths<Weight>::BuildRoutes(VertexId from,
+		VertexId to, size_t count, const PathFilter& filter, size_t max_paths) const
+	{
+		CheckVertex(from);
+		CheckVertex(to);
+		std::vector<RouteInfo> result;
+		if (count == 0)
+		{
+			return result;
+		}
+		if (from == to)
+		{
+			// путь без повторения вершин из вершины в неё саму только пустой
+			result.push_back(RouteInfo{ WeightTraits<Weight>::FromKey(ZERO_KEY), {} });
+			return result;
+		}
+
+		auto state = states_.Acquire();
+		GrowReverseTree(*state, to);
+		std::vector<EdgeId> first_edges;
+		ResetBans(*state);
+		if (!FindSpur(*state, from, first_edges))
+		{
+			return result;
+		}
+
+		std::vector<Path> found;
+		found.emplace_back(ComputeWeight(first_edges), std::move(first_edges));
+		// номера принятых путей в found
+		std::vector<size_t> accepted;
+		if (!filter || filter(found.back().second))
+		{
+			accepted.push_back(0);
+		}
+		std::set<Path> candidates;
+		// рёбра всех найденных путей и кандидатов: одно ответвление может дать путь, уже полученный иначе
+		std::set<std::vector<EdgeId>> known_paths{ found.back().second };
+		while (accepted.size() < count && found.size() < max_paths)
+		{
+			const std::vector<EdgeId> last_edges = found.back().second;
+			VertexId spur_vertex = from;
+			for (size_t spur_index = 0; spur_index < last_edges.size(); ++spur_index)
+			{
+				ResetBans(*state);
+				// продолжения найденных путей с тем же началом, что и у ответвления
+				for (const auto& [weight, edges] : found)
+				{
+					if (edges.size() > spur_index && std::equal(edges.begin(), edges.begin() + spur_index, last_edges.begin()))
+					{
+						state->banned_edges[edges[spur_index]] = state->ban_stamp;
+					}
+				}
+				// вершины общего начала, кроме самой вершины ответвления
+				for (size_t i = 0; i < spur_index; ++i)
+				{
+					state->banned_vertices[graph_.GetEdgeSource(last_edges[i])] = state->ban_stamp;
+				}
+
+				std::vector<EdgeId> edges(last_edges.begin(), last_edges.begin() + spur_index);
+				if (FindSpur(*state, spur_vertex, edges) && known_paths.insert(edges).second)
+				{
+					const Key weight = ComputeWeight(edges);
+					candidates.emplace(weight, std::move(edges));
+				}
+				spur_vertex = graph_.GetEdgeTarget(last_edges[spur_index]);
+			}
+
+			if (candidates.empty())
+			{
+				break;
+			}
+			found.push_back(std::move(candidates.extract(candidates.begin()).value()));
+			if (!filter || filter(found.back().second))
+			{
+				accepted.push_back(found.size() - 1);
+			}
+		}
+
+		result.reserve(accepted.size());
+		for (const size_t index : accepted)
+		{
+			auto& [weight, edges] = found[index];
+			result.push_back(RouteInfo{ WeightTraits<Weight>::FromKey(weight), std::move(edges) });
+		}
+		return result;
+	}
+
+	template <typename Weight>
+	void KShortestPaths<Weight>::CheckVertex(VertexId vertex) const
+	{
+		if (vertex >= graph_.GetVertexCount())
+		{
+			throw std::out_of_range("Vertex id is out of range");
+		}
+	}
+
+	template <typename Weight>
+	void KShortestPaths<Weight>::GrowReverseTree(QueryState& state, VertexId to) const
+	{
+		SearchState<Key>& tree = state.tree;
+		tree.Reset(graph_.GetVertexCount());
+		tree.Reach(to, ZERO_KEY, SearchState<Key>::NO_EDGE);
+		tree.Push(ZERO_KEY, ZERO_KEY, to);
+		while (!tree.IsQueueEmpty())
+		{
+			const auto item = tree.Pop();
+			if (tree.GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			for (const EdgeId edge_id : graph_.GetIncomingEdges(item.vertex))
+			{
+				const VertexId prev_vertex = graph_.GetEdgeSource(edge_id);
+				const Key candidate_weight = item.weight + graph_.GetEdgeKey(edge_id);
+				if (!tree.IsReached(prev_vertex) || candidate_weight < tree.GetWeight(prev_vertex))
+				{
+					tree.Reach(prev_vertex, candidate_weight, edge_id);
+					tree.Push(candidate_weight, candidate_weight, prev_vertex);
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	void KShortestPaths<Weight>::ResetBans(QueryState& state) const
+	{
+		const size_t vertex_count = graph_.GetVertexCount();
+		const size_t edge_count = graph_.GetEdgeCount();
+		if (state.banned_vertices.size() < vertex_count || state.banned_edges.size() < edge_count)
+		{
+			state.banned_vertices.resize(std::max(state.banned_vertices.size(), vertex_count), 0);
+			state.banned_edges.resize(std::max(state.banned_edges.size(), edge_count), 0);
+		}
+		if (++state.ban_stamp == 0)
+		{
+			std::fill(state.banned_vertices.begin(), state.banned_vertices.end(), 0);
+			std::fill(state.banned_edges.begin(), state.banned_edges.end(), 0);
+			state.ban_stamp = 1;
+		}
+	}
+
+	template <typename Weight>
+	bool KShortestPaths<Weight>::FindSpur(QueryState& state, VertexId from, std::vector<EdgeId>& edges) const
+	{
+		const SearchState<Key>& tree = state.tree;
+		if (!tree.IsReached(from))
+		{
+			return false;
+		}
+
+		// A* с оценкой по обратному дереву: оценка точна в полном графе и не больше
+		// веса пути в графе с запретами
+		SearchState<Key>& spur = state.spur;
+		spur.Reset(graph_.GetVertexCount());
+		spur.Reach(from, ZERO_KEY, SearchState<Key>::NO_EDGE);
+		spur.Push(tree.GetWeight(from), ZERO_KEY, from);
+		while (!spur.IsQueueEmpty())
+		{
+			const auto item = spur.Pop();
+			if (spur.GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			// приоритет извлечённой вершины - точный вес её продолжения по дереву и нижняя
+			// оценка всех остальных путей, поэтому допустимое продолжение даёт кратчайший путь;
+			// у самой цели продолжение пустое
+			if (AppendTreePath(state, from, item.vertex, edges))
+			{
+				return true;
+			}
+			for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex))
+			{
+				const VertexId next_vertex = graph_.GetEdgeTarget(edge_id);
+				if (state.banned_edges[edge_id] == state.ban_stamp || state.banned_vertices[next_vertex] == state.ban_stamp
+					|| !tree.IsReached(next_vertex))
+				{
+					continue;
+				}
+				const Key candidate_weight = item.weight + graph_.GetEdgeKey(edge_id);
+				if (!spur.IsReached(next_vertex) || candidate_weight < spur.GetWeight(next_vertex))
+				{
+					spur.Reach(next_vertex, candidate_weight, edge_id);
+					spur.Push(candidate_weight + tree.GetWeight(next_vertex), candidate_weight, next_vertex);
+				}
+			}
+		}
+
+		return false;
+	}
+
+	template <typename Weight>
+	bool KShortestPaths<Weight>::AppendTreePath(QueryState& state, VertexId from, VertexId vertex,
+		std::vector<EdgeId>& edges) const
+	{
+		if (state.path_vertices.size() < graph_.GetVertexCount())
+		{
+			state.path_vertices.resize(graph_.GetVertexCount(), 0);
+		}
+		if (++state.path_stamp == 0)
+		{
+			std::fill(state.path_vertices.begin(), state.path_vertices.end(), 0);
+			state.path_stamp = 1;
+		}
+		// вершины найденной части ответвления: склеенный путь не должен проходить их повторно
+		const SearchState<Key>& spur = state.spur;
+		state.path_vertices[vertex] = state.path_stamp;
+		for (VertexId path_vertex = vertex; path_vertex != from;)
+		{
+			path_vertex = graph_.GetEdgeSource(spur.GetPrevEdge(path_vertex));
+			state.path_vertices[path_vertex] = state.path_stamp;
+		}
+
+		const SearchState<Key>& tree = state.tree;
+		const size_t spur_end = edges.size();
+		for (EdgeId edge_id = tree.GetPrevEdge(vertex); edge_id != SearchState<Key>::NO_EDGE;)
+		{
+			const VertexId next_vertex = graph_.GetEdgeTarget(edge_id);
+			if (state.banned_edges[edge_id] == state.ban_stamp || state.banned_vertices[next_vertex] == state.ban_stamp
+				|| state.path_vertices[next_vertex] == state.path_stamp)
+			{
+				edges.resize(spur_end);
+				return false;
+			}
+			state.path_vertices[next_vertex] = state.path_stamp;
+			edges.push_back(edge_id);
+			edge_id = tree.GetPrevEdge(next_vertex);
+		}
+
+		// путь дерева допустим: перед ним встаёт найденная часть ответвления
+		const size_t spur_begin = edges.size();
+		for (VertexId path_vertex = vertex; path_vertex != from;)
+		{
+			const EdgeId edge_id = spur.GetPrevEdge(path_vertex);
+			edges.push_back(edge_id);
+			path_vertex = graph_.GetEdgeSource(edge_id);
+		}
+		std::reverse(edges.begin() + spur_begin, edges.end());
+		std::rotate(edges.begin() + spur_end, edges.begin() + spur_begin, edges.end());
+		return true;
+	}
+
+	template <typename Weight>
+	typename KShortestPaths<Weight>::Key KShortestPaths<Weight>::ComputeWeight(const std::vector<EdgeId>& edges) const
+	{
+		Key weight = ZERO_KEY;
+		for (const EdgeId edge_id : edges)
+		{
+			weight = weight + graph_.GetEdgeKey(edge_id);
+		}
+		return weight;
+	}
+} // namespace graph
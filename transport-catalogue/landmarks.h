@@ -0,0 +1,219 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "parallel.h"
+#include "search_state.h"
+
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// ALT (A*, landmarks, triangle inequality): предрасчитанные веса путей от опорных вершин
+	// и до них дают для A* нижнюю оценку пути v -> t по неравенству треугольника:
+	// d(v, t) >= d(L, t) - d(L, v) и d(v, t) >= d(v, L) - d(t, L)
+	template <typename Weight>
+	class Landmarks
+	{
+	private:
+		using Graph = FrozenGraph<Weight>;
+		using Key = typename WeightTraits<Weight>::Key;
+
+	public:
+		// отметка "пути нет" в таблицах
+		static constexpr Key UNREACHABLE = std::numeric_limits<Key>::max();
+
+		// таблицы весов без владения данными; ячейка vertex * landmarks.size() + landmark,
+		// так что оценки всех опорных вершин для одной вершины графа лежат рядом
+		struct TablesView
+		{
+			size_t vertex_count = 0;
+			std::vector<VertexId> landmarks;
+			const Key* distances_from = nullptr;  // d(landmark, vertex)
+			const Key* distances_to = nullptr;    // d(vertex, landmark)
+		};
+
+		// нижняя оценка пути до фиксированной цели; веса цели извлекаются один раз на запрос
+		class Potential
+		{
+		public:
+			Key operator()(VertexId vertex) const;
+
+		private:
+			friend class Landmarks;
+			Potential(const Landmarks& landmarks, VertexId target);
+
+			const Landmarks& landmarks_;
+			std::vector<Key> target_from_;  // d(landmark, target)
+			std::vector<Key> target_to_;    // d(target, landmark)
+		};
+
+		// считает таблицы для заданных опорных вершин; прямой и обратный поиск от каждой
+		// опорной вершины выполняются параллельно. threads_count == 0 - все аппаратные потоки
+		Landmarks(const Graph& graph, std::vector<VertexId> landmarks, size_t threads_count = 0);
+		// использует готовые таблицы во внешней памяти без копирования; storage продлевает их жизнь
+		Landmarks(const Graph& graph, TablesView tables, std::shared_ptr<const void> storage);
+
+		Landmarks(const Landmarks&) = delete;
+		Landmarks& operator=(const Landmarks&) = delete;
+
+		Potential MakePotential(VertexId target) const;
+
+		const TablesView& GetTables() const;
+
+	private:
+		void ComputeDistances(VertexId landmark, size_t landmark_index, bool forward);
+
+		const Graph& graph_;
+		std::vector<Key> distances_from_;
+		std::vector<Key> distances_to_;
+		TablesView tables_;
+		std::shared_ptr<const void> storage_;
+	};
+
+	template <typename Weight>
+	Landmarks<Weight>::Landmarks(const Graph& graph, std::vector<VertexId> landmarks, size_t threads_count)
+		: graph_(graph)
+	{
+		const size_t vertex_count = graph_.GetVertexCount();
+		for (const VertexId landmark : landmarks)
+		{
+			if (landmark >= vertex_count)
+			{
+				throw std::out_of_range("Landmark id is out of range");
+			}
+		}
+		tables_.vertex_count = vertex_count;
+		tables_.landmarks = std::move(landmarks);
+		const size_t landmarks_count = tables_.landmarks.size();
+		distances_from_.assign(vertex_count * landmarks_count, UNREACHABLE);
+		distances_to_.assign(vertex_count * landmarks_count, UNREACHABLE);
+
+		// задачи 2i и 2i + 1 - прямой и обратный поиск от i-й опорной вершины;
+		// каждая пишет только в свой столбец таблицы
+		parallel::ThreadPool pool(threads_count);
+		pool.Run(landmarks_count * 2, [this](size_t task)
+		{
+			const size_t landmark_index = task / 2;
+			ComputeDistances(tables_.landmarks[landmark_index], landmark_index, task % 2 == 0);
+		});
+
+		tables_.distances_from = distances_from_.data();
+		tables_.distances_to = distances_to_.data();
+	}
+
+	template <typename Weight>
+	Landmarks<Weight>::Landmarks(const Graph& graph, TablesView tables, std::shared_ptr<const void> storage)
+		: graph_(graph)
+		, tables_(std::move(tables))
+		, storage_(std::move(storage))
+	{
+		if (tables_.vertex_count != graph.GetVertexCount())
+		{
+			throw std::invalid_argument("Landmark tables size should match vertex count");
+		}
+	}
+
+	template <typename Weight>
+	void Landmarks<Weight>::ComputeDistances(VertexId landmark, size_t landmark_index, bool forward)
+	{
+		const size_t vertex_count = graph_.GetVertexCount();
+		const size_t landmarks_count = tables_.landmarks.size();
+		auto& distances = forward ? distances_from_ : distances_to_;
+
+		SearchState<Key> state;
+		auto relax = [this, &state, forward](const Key& weight, EdgeId edge_id)
+		{
+			const VertexId next_vertex = forward ? graph_.GetEdgeTarget(edge_id) : graph_.GetEdgeSource(edge_id);
+			const Key candidate_weight = weight + graph_.GetEdgeKey(edge_id);
+			if (!state.IsReached(next_vertex) || candidate_weight < state.GetWeight(next_vertex))
+			{
+				state.Reach(next_vertex, candidate_weight, edge_id);
+				state.Push(candidate_weight, candidate_weight, next_vertex);
+			}
+		};
+
+		state.Reset(vertex_count);
+		state.Reach(landmark, Key{}, SearchState<Key>::NO_EDGE);
+		state.Push(Key{}, Key{}, landmark);
+		while (!state.IsQueueEmpty())
+		{
+			const auto item = state.Pop();
+			if (state.GetWeight(item.vertex) < item.weight)
+			{
+				continue;
+			}
+			distances[item.vertex * landmarks_count + landmark_index] = item.weight;
+			if (forward)
+			{
+				for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex))
+				{
+					relax(item.weight, edge_id);
+				}
+			}
+			else
+			{
+				for (const EdgeId edge_id : graph_.GetIncomingEdges(item.vertex))
+				{
+					relax(item.weight, edge_id);
+				}
+			}
+		}
+	}
+
+	template <typename Weight>
+	typename Landmarks<Weight>::Potential Landmarks<Weight>::MakePotential(VertexId target) const
+	{
+		return Potential(*this, target);
+	}
+
+	template <typename Weight>
+	const typename Landmarks<Weight>::TablesView& Landmarks<Weight>::GetTables() const
+	{
+		return tables_;
+	}
+
+	template <typename Weight>
+	Landmarks<Weight>::Potential::Potential(const Landmarks& landmarks, VertexId target)
+		: landmarks_(landmarks)
+	{
+		const size_t landmarks_count = landmarks.tables_.landmarks.size();
+		const size_t row = target * landmarks_count;
+		target_from_.assign(landmarks.tables_.distances_from + row, landmarks.tables_.distances_from + row + landmarks_count);
+		target_to_.assign(landmarks.tables_.distances_to + row, landmarks.tables_.distances_to + row + landmarks_count);
+	}
+
+	template <typename Weight>
+	typename Landmarks<Weight>::Key Landmarks<Weight>::Potential::operator()(VertexId vertex) const
+	{
+		const size_t landmarks_count = target_from_.size();
+		const size_t row = vertex * landmarks_count;
+		const Key* vertex_from = landmarks_.tables_.distances_from + row;
+		const Key* vertex_to = landmarks_.tables_.distances_to + row;
+		Key bound{};
+		for (size_t i = 0; i < landmarks_count; ++i)
+		{
+			// опорная вершина достигает цели, но не vertex: оценка не определена
+			if (target_from_[i] != UNREACHABLE && vertex_from[i] != UNREACHABLE && bound < target_from_[i] - vertex_from[i])
+			{
+				bound = target_from_[i] - vertex_from[i];
+			}
+			if (target_to_[i] != UNREACHABLE)
+			{
+				// цель достигает опорной вершины, а vertex нет - значит, и цели vertex не достигает
+				if (vertex_to[i] == UNREACHABLE)
+				{
+					return UNREACHABLE;
+				}
+				if (bound < vertex_to[i] - target_to_[i])
+				{
+					bound = vertex_to[i] - target_to_[i];
+				}
+			}
+		}
+		return bound;
+	}
+} // namespace graph
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cache
+{
+	// Ограниченный кэш с вытеснением давно не использованных записей. Ключи распределены
+	// по независимым сегментам со своими мьютексами, поэтому параллельные обращения
+	// к разным ключам почти не конкурируют за блокировку
+	template <typename Key, typename Value, typename Hash = std::hash<Key>>
+	class ShardedLruCache final
+	{
+	public:
+		struct Statistics
+		{
+			size_t hits = 0;
+			size_t misses = 0;
+		};
+
+		static constexpr size_t DEFAULT_SHARDS_COUNT = 16;
+
+		// capacity - общее число записей, делится между сегментами поровну
+		explicit ShardedLruCache(size_t capacity, size_t shards_count = DEFAULT_SHARDS_COUNT);
+
+		ShardedLruCache(const ShardedLruCache&) = delete;
+		ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+		// копия значения по ключу; найденная запись становится самой свежей
+		std::optional<Value> Find(const Key& key);
+		// добавляет или заменяет запись, при переполнении сегмента вытесняя самую старую
+		void Insert(const Key& key, Value value);
+
+		Statistics GetStatistics() const;
+
+	private:
+		struct Shard
+		{
+			std::mutex mutex;
+			size_t capacity = 0;
+			// от свежих записей к старым
+			std::list<std::pair<Key, Value>> items;
+			std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash> index;
+		};
+
+		Shard& GetShard(const Key& key);
+
+		Hash hasher_;
+		std::vector<Shard> shards_;
+		std::atomic<size_t> hits_{ 0 };
+		std::atomic<size_t> misses_{ 0 };
+	};
+
+	template <typename Key, typename Value, typename Hash>
+	ShardedLruCache<Key, Value, Hash>::ShardedLruCache(size_t capacity, size_t shards_count)
+		: shards_(std::max<size_t>(std::min(shards_count, capacity), 1))
+	{
+		for (size_t i = 0; i < shards_.size(); ++i)
+		{
+			// остаток от деления достаётся первым сегментам
+			shards_[i].capacity = capacity / shards_.size() + (i < capacity % shards_.size() ? 1 : 0);
+		}
+	}
+
+	template <typename Key, typename Value, typename Hash>
+	std::optional<Value> ShardedLruCache<Key, Value, Hash>::Find(const Key& key)
+	{
+		Shard& shard = GetShard(key);
+		std::lock_guard lock(shard.mutex);
+		auto it = shard.index.find(key);
+		if (it == shard.index.end())
+		{
+			misses_.fetch_add(1, std::memory_order_relaxed);
+			return std::nullopt;
+		}
+		hits_.fetch_add(1, std::memory_order_relaxed);
+		shard.items.splice(shard.items.begin(), shard.items, it->second);
+		return it->second->second;
+	}
+
+	template <typename Key, typename Value, typename Hash>
+	void ShardedLruCache<Key, Value, Hash>::Insert(const Key& key, Value value)
+	{
+		Shard& shard = GetShard(key);
+		if (shard.capacity == 0)
+		{
+			return;
+		}
+		std::lock_guard lock(shard.mutex);
+		auto it = shard.index.find(key);
+		if (it != shard.index.end())
+		{
+			it->second->second = std::move(value);
+			shard.items.splice(shard.items.begin(), shard.items, it->second);
+			return;
+		}
+		if (shard.items.size() == shard.capacity)
+		{
+			shard.index.erase(shard.items.back().first);
+			shard.items.pop_back();
+		}
+		shard.items.emplace_front(key, std::move(value));
+		shard.index.emplace(key, shard.items.begin());
+	}
+
+	template <typename Key, typename Value, typename Hash>
+	typename ShardedLruCache<Key, Value, Hash>::Statistics ShardedLruCache<Key, Value, Hash>::GetStatistics() const
+	{
+		return { hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed) };
+	}
+
+	template <typename Key, typename Value, typename Hash>
+	typename ShardedLruCache<Key, Value, Hash>::Shard& ShardedLruCache<Key, Value, Hash>::GetShard(const Key& key)
+	{
+		return shards_[hasher_(key) % shards_.size()];
+	}
+} // namespace cache
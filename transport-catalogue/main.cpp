@@ -9,7 +9,7 @@ using namespace std;
 
 void PrintUsage(std::ostream& stream = std::cerr) 
 {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests|update_base]\n"sv;
 }
 
 int main(int argc, char* argv[])
@@ -29,8 +29,10 @@ int main(int argc, char* argv[])
     if (mode == "make_base"sv) 
     {
         transport_catalogue::JsonReader json(catalogue, std::cin);
-        catalogue_handler.LoadDataFromJson(json);
-        catalogue_handler.SerializeData();
+        if (!catalogue_handler.LoadDataFromJson(json) || !catalogue_handler.SerializeData())
+        {
+            return 1;
+        }
 
     }
     else if (mode == "process_requests"sv) 
@@ -40,6 +42,15 @@ int main(int argc, char* argv[])
         catalogue_handler.DeserializeData();
         catalogue_handler.LoadRequestsAndAnswer(json);
     } 
+    else if (mode == "update_base"sv)
+    {
+        transport_catalogue::JsonReader json(catalogue, std::cin);
+        catalogue_handler.LoadSerializeSettings(json);
+        if (!catalogue_handler.DeserializeData() || !catalogue_handler.UpdateData(json))
+        {
+            return 1;
+        }
+    }
     else
     {
         PrintUsage();
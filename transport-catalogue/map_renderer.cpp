@@ -6,17 +6,14 @@ namespace transport_catalogue
 {
 	namespace detail
 	{
-		std::deque<geo::Coordinates> FilterCoordinates(const std::unordered_map<std::string_view, std::set<std::string>>& stop_buses, const std::unordered_map<std::string_view, Stop*>& stops)
+		std::deque<geo::Coordinates> FilterCoordinates(const TransportCatalogue& catalogue)
 		{
 			std::deque<geo::Coordinates> result;
-			for (const auto& stop : stops)
+			for (StopId stop_id = 0; stop_id < catalogue.GetStopCount(); ++stop_id)
 			{
-				if (stop_buses.count(stop.second->name) > 0)
+				if (!catalogue.GetStopBusIds(stop_id).empty())
 				{
-					if (stop_buses.at(stop.second->name).size() > 0)
-					{
-						result.push_back(stop.second->coordinates);
-					}
+					result.push_back(catalogue.GetStop(stop_id).coordinates);
 				}
 			}
 			return result;
@@ -29,45 +26,63 @@ namespace transport_catalogue
 		settings_ = settings;
 	}
 
-	svg::Document MapRenderer::RenderMap(const std::unordered_map<std::string_view, Bus*>& buses,
-		const std::unordered_map<std::string_view, Stop*>& stops,
-		const std::unordered_map<std::string_view, std::set<std::string>>& stop_buses)
+	svg::Document MapRenderer::RenderMap(const TransportCatalogue& catalogue)
 	{
+		return RenderNetwork(catalogue, [](const Stop&)
+		{
+			return true;
+		});
+	}
 
+	svg::Document MapRenderer::RenderReachableStops(const TransportCatalogue& catalogue,
+		const std::unordered_set<std::string_view>& reachable_stops)
+	{
+		return RenderNetwork(catalogue, [&reachable_stops](const Stop& stop)
+		{
+			return reachable_stops.count(stop.name) > 0;
+		});
+	}
 
-
-		const auto& stop_coordinates = detail::FilterCoordinates(stop_buses, stops);
+	svg::Document MapRenderer::RenderNetwork(const TransportCatalogue& catalogue, const StopFilter& stop_filter) const
+	{
+		const auto& stop_coordinates = detail::FilterCoordinates(catalogue);
 		detail::SphereProjector sphere_projector(stop_coordinates.begin(), stop_coordinates.end(),
 			settings_.size.x, settings_.size.y, settings_.padding);
 
 		// перекладываем в map, для упорядочивания по имени
 		Buses sorted_buses;
 		Stops sorted_stops;
-		for (auto& bus : buses)
+		for (auto& bus : catalogue.GetBusnameToBus())
 		{
 			sorted_buses.insert(bus);
 		}
-		for (auto& stop : stops)
+		for (auto& stop : catalogue.GetStopnameToStop())
 		{
-			sorted_stops.insert(stop);
+			// рисуются только остановки, которые входят в какой-либо маршрут
+			if (!catalogue.GetStopBusIds(stop.second->id).empty() && stop_filter(*stop.second))
+			{
+				sorted_stops.insert(stop);
+			}
 		}
 
 		svg::Document document;
-		RenderLines(document, sorted_buses, sphere_projector);
-		RenderBusNames(document, sorted_buses, sphere_projector);
-		RenderStops(document, sorted_stops, stop_buses, sphere_projector);
-		RenderStopNames(document, sorted_stops, stop_buses, sphere_projector);
+		RenderLines(document, catalogue, sorted_buses, sphere_projector);
+		RenderBusNames(document, catalogue, sorted_buses, sphere_projector);
+		RenderStops(document, sorted_stops, sphere_projector);
+		RenderStopNames(document, sorted_stops, sphere_projector);
 		return document;
 	}
 
-	void MapRenderer::RenderLines(svg::Document& document, const Buses& buses, const detail::SphereProjector& sphere_projector) const
+	void MapRenderer::RenderLines(svg::Document& document, const TransportCatalogue& catalogue, const Buses& buses,
+		const detail::SphereProjector& sphere_projector) const
 	{
 		auto max_color_count = settings_.color_palette.size();
 		size_t color_index = 0;
 		for (const auto& bus : buses)
 		{
+			const auto stops = catalogue.GetBusStops(bus.second->id);
 			// работает только с не пустыми маршрутами
-			if (bus.second->stops.size() == 0)
+			if (stops.empty())
 			{
 				continue;
 			}
@@ -77,16 +92,16 @@ namespace transport_catalogue
 				SetFillColor(svg::NoneColor).SetStrokeWidth(settings_.line_width).
 				SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
 			// проходим по маршруту, добавляя точки от первой остановки до последней
-			for (auto iter = bus.second->stops.begin(); iter < bus.second->stops.end(); ++iter)
+			for (auto iter = stops.begin(); iter < stops.end(); ++iter)
 			{
-				line.AddPoint(sphere_projector((*iter)->coordinates));
+				line.AddPoint(sphere_projector(catalogue.GetStopCoordinates(*iter)));
 			}
 			// проходим по маршруту назад если он не кольцевой
 			if (bus.second->is_roundtrip == false)
 			{
-				for (auto iter = std::next(bus.second->stops.rbegin()); iter < bus.second->stops.rend(); ++iter)
+				for (size_t i = stops.size() - 1; i > 0; --i)
 				{
-					line.AddPoint(sphere_projector((*iter)->coordinates));
+					line.AddPoint(sphere_projector(catalogue.GetStopCoordinates(stops[i - 1])));
 				}
 			}
 			document.Add(line);
@@ -94,19 +109,21 @@ namespace transport_catalogue
 		}
 	}
 
-	void MapRenderer::RenderBusNames(svg::Document& document, const Buses& buses, const detail::SphereProjector& sphere_projector) const
+	void MapRenderer::RenderBusNames(svg::Document& document, const TransportCatalogue& catalogue, const Buses& buses,
+		const detail::SphereProjector& sphere_projector) const
 	{
 		auto max_color_count = settings_.color_palette.size();
 		size_t color_index = 0;
 		for (const auto& bus : buses)
 		{
+			const auto stops = catalogue.GetBusStops(bus.second->id);
 			// работает только не с пустыми маршрутами
-			if (bus.second->stops.size() > 0)
+			if (!stops.empty())
 			{
 				// задаем общие параметры отрисовки текста и подложки
 				svg::Text text, underlayer_text;
 				text.SetData(std::string(bus.first)).
-					SetPosition(sphere_projector(bus.second->stops.front()->coordinates)).
+					SetPosition(sphere_projector(catalogue.GetStopCoordinates(stops[0]))).
 					SetOffset(settings_.bus_label_offset).
 					SetFontSize(static_cast<std::uint32_t>(settings_.bus_label_font_size)).
 					SetFontFamily("Verdana"s).SetFontWeight("bold");
@@ -122,10 +139,10 @@ namespace transport_catalogue
 				// если маршрут не кольцевой и первая остановка не совпадает с последней
 				// то отрисовываем название маршрута у последней остановки
 				if (bus.second->is_roundtrip == false &&
-					bus.second->stops.back() != bus.second->stops.front())
+					stops[stops.size() - 1] != stops[0])
 				{
-					text.SetPosition(sphere_projector(bus.second->stops.back()->coordinates));
-					underlayer_text.SetPosition(sphere_projector(bus.second->stops.back()->coordinates));
+					text.SetPosition(sphere_projector(catalogue.GetStopCoordinates(stops[stops.size() - 1])));
+					underlayer_text.SetPosition(sphere_projector(catalogue.GetStopCoordinates(stops[stops.size() - 1])));
 					document.Add(underlayer_text);
 					document.Add(text);
 				}
@@ -134,45 +151,37 @@ namespace transport_catalogue
 		}
 	}
 
-	void MapRenderer::RenderStops(svg::Document& document, const Stops& stops, const StopBuses& stop_buses, const detail::SphereProjector& sphere_projector) const
+	void MapRenderer::RenderStops(svg::Document& document, const Stops& stops, const detail::SphereProjector& sphere_projector) const
 	{
 		for (const auto& stop : stops)
 		{
-			// проходим по всем остановкам, которые входят в какой либо маршрут
-			if (stop_buses.count(stop.first) != 0)
-			{
-				// отрисовываем значок остановки
-				svg::Circle circle;
-				circle.SetCenter(sphere_projector(stop.second->coordinates)).
-					SetRadius(settings_.stop_radius).SetFillColor("white"s);
-				document.Add(circle);
-			}
+			// отрисовываем значок остановки
+			svg::Circle circle;
+			circle.SetCenter(sphere_projector(stop.second->coordinates)).
+				SetRadius(settings_.stop_radius).SetFillColor("white"s);
+			document.Add(circle);
 		}
 	}
 
-	void MapRenderer::RenderStopNames(svg::Document& document, const Stops& stops, const StopBuses& stop_buses, const detail::SphereProjector& sphere_projector) const
+	void MapRenderer::RenderStopNames(svg::Document& document, const Stops& stops, const detail::SphereProjector& sphere_projector) const
 	{
 		for (const auto& stop : stops)
 		{
-			// проходим по всем остановкам, которые входят в какой либо маршрут
-			if (stop_buses.count(stop.first) != 0)
-			{
-				// формируем текст и подложку
-				svg::Text text, underlayer_text;
-				text.SetData(std::string(stop.first)).SetPosition(sphere_projector(stop.second->coordinates)).
-					SetOffset(settings_.stop_label_offset).
-					SetFontSize(static_cast<std::uint32_t>(settings_.stop_label_font_size)).
-					SetFontFamily("Verdana");
-				underlayer_text = text;
-				// добавляем индивидуальные для текста и подложки параметры
-				text.SetFillColor("black");
-				underlayer_text.SetFillColor(settings_.underlayer_color).SetStrokeColor(settings_.underlayer_color).
-					SetStrokeWidth(settings_.underlayer_width).
-					SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-				// отрисовываем подложку и текст
-				document.Add(underlayer_text);
-				document.Add(text);
-			}
+			// формируем текст и подложку
+			svg::Text text, underlayer_text;
+			text.SetData(std::string(stop.first)).SetPosition(sphere_projector(stop.second->coordinates)).
+				SetOffset(settings_.stop_label_offset).
+				SetFontSize(static_cast<std::uint32_t>(settings_.stop_label_font_size)).
+				SetFontFamily("Verdana");
+			underlayer_text = text;
+			// добавляем индивидуальные для текста и подложки параметры
+			text.SetFillColor("black");
+			underlayer_text.SetFillColor(settings_.underlayer_color).SetStrokeColor(settings_.underlayer_color).
+				SetStrokeWidth(settings_.underlayer_width).
+				SetStrokeLineCap(svg::StrokeLineCap::ROUND).SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+			// отрисовываем подложку и текст
+			document.Add(underlayer_text);
+			document.Add(text);
 		}
 	}
 }// namespace map_renderer
\ No newline at end of file
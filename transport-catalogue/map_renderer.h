@@ -8,8 +8,10 @@
 #include <map>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <deque>
+#include <functional>
 #include <algorithm>
 #include <iostream>
 #include <variant>
@@ -18,7 +20,8 @@ namespace transport_catalogue
 {
 	namespace detail
 	{
-		std::deque<geo::Coordinates> FilterCoordinates(const std::unordered_map<std::string_view, std::set<std::string>>& stop_buses, const std::unordered_map<std::string_view, Stop*>& stops);
+		// координаты остановок, через которые проходит хотя бы один автобус
+		std::deque<geo::Coordinates> FilterCoordinates(const TransportCatalogue& catalogue);
 
 		inline const double EPSILON = 1e-6;
 		inline bool IsZero(double value)
@@ -122,20 +125,31 @@ namespace transport_catalogue
 	public:
 		using Buses = std::map<std::string_view, const Bus*>;
 		using Stops = std::map<std::string_view, const Stop*>;
-		using StopBuses = std::unordered_map<std::string_view, std::set<std::string>>;
 
 		void SetSettings(const RenderSettings& settings);
 
-		svg::Document RenderMap(const std::unordered_map<std::string_view, Bus*>& buses,
-			const std::unordered_map<std::string_view, Stop*>& stops,
-			const std::unordered_map<std::string_view, std::set<std::string>>& stop_buses);
+		svg::Document RenderMap(const TransportCatalogue& catalogue);
+
+		// карта, на которой отмечены только остановки из reachable_stops; масштаб и линии
+		// маршрутов - по всей сети, чтобы зона доступности была видна на её фоне
+		svg::Document RenderReachableStops(const TransportCatalogue& catalogue,
+			const std::unordered_set<std::string_view>& reachable_stops);
 
 	private:
+		// рисуются остановки с автобусами, для которых фильтр вернул true
+		using StopFilter = std::function<bool(const Stop&)>;
+
 		RenderSettings settings_;
 
-		void RenderLines(svg::Document& document, const Buses& buses, const detail::SphereProjector& sphere_projector) const;
-		void RenderBusNames(svg::Document& document, const Buses& buses, const detail::SphereProjector& sphere_projector) const;
-		void RenderStops(svg::Document& document, const Stops& stops, const StopBuses& stop_buses, const detail::SphereProjector& sphere_projector) const;
-		void RenderStopNames(svg::Document& document, const Stops& stops, const StopBuses& stop_buses, const detail::SphereProjector& sphere_projector) const;
+		// масштаб, линии и названия маршрутов всегда по всей сети, остановки - по фильтру
+		svg::Document RenderNetwork(const TransportCatalogue& catalogue, const StopFilter& stop_filter) const;
+
+		void RenderLines(svg::Document& document, const TransportCatalogue& catalogue, const Buses& buses,
+			const detail::SphereProjector& sphere_projector) const;
+		void RenderBusNames(svg::Document& document, const TransportCatalogue& catalogue, const Buses& buses,
+			const detail::SphereProjector& sphere_projector) const;
+		// остановки рисуются все переданные: без автобусов их отбрасывают при сборе Stops
+		void RenderStops(svg::Document& document, const Stops& stops, const detail::SphereProjector& sphere_projector) const;
+		void RenderStopNames(svg::Document& document, const Stops& stops, const detail::SphereProjector& sphere_projector) const;
 	};
 }// namespace map_renderer
\ No newline at end of file
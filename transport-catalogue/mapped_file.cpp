@@ -0,0 +1,87 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace serialize
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::filesystem::path& path)
+	{
+		std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+		if (!ifs.is_open())
+		{
+			return;
+		}
+		buffer_.resize(static_cast<size_t>(ifs.tellg()));
+		ifs.seekg(0);
+		if (!ifs.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size())))
+		{
+			return;
+		}
+		data_ = buffer_.data();
+		size_ = buffer_.size();
+		is_open_ = true;
+	}
+
+	MappedFile::~MappedFile() = default;
+#else
+	MappedFile::MappedFile(const std::filesystem::path& path)
+	{
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+		{
+			return;
+		}
+		struct stat file_stat;
+		if (::fstat(fd, &file_stat) == 0)
+		{
+			size_ = static_cast<size_t>(file_stat.st_size);
+			if (size_ == 0)
+			{
+				is_open_ = true;
+			}
+			else
+			{
+				void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+				if (data != MAP_FAILED)
+				{
+					data_ = static_cast<const char*>(data);
+					is_open_ = true;
+				}
+			}
+		}
+		// отображение остаётся действительным и после закрытия дескриптора
+		::close(fd);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (data_ != nullptr)
+		{
+			::munmap(const_cast<char*>(data_), size_);
+		}
+	}
+#endif
+
+	bool MappedFile::IsOpen() const
+	{
+		return is_open_;
+	}
+
+	const char* MappedFile::GetData() const
+	{
+		return data_;
+	}
+
+	size_t MappedFile::GetSize() const
+	{
+		return size_;
+	}
+} // namespace serialize
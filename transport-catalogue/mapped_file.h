@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+namespace serialize
+{
+	// файл, отображённый в память только для чтения. Страницы отображения разделяются
+	// всеми процессами, открывшими тот же файл, через общий страничный кэш
+	class MappedFile final
+	{
+	public:
+		explicit MappedFile(const std::filesystem::path& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool IsOpen() const;
+
+		const char* GetData() const;
+		size_t GetSize() const;
+
+	private:
+		const char* data_ = nullptr;
+		size_t size_ = 0;
+		bool is_open_ = false;
+#ifdef _WIN32
+		// на платформах без mmap файл читается в память целиком
+		std::vector<char> buffer_;
+#endif
+	};
+} // namespace serialize
@@ -0,0 +1,107 @@
+#include "parallel.h"
+
+namespace parallel
+{
+	ThreadPool::ThreadPool(size_t threads_count)
+	{
+		if (threads_count == 0)
+		{
+			threads_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		}
+		workers_.reserve(threads_count - 1);
+		for (size_t i = 1; i < threads_count; ++i)
+		{
+			workers_.emplace_back([this] { WorkerLoop(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock(mutex_);
+			stop_ = true;
+		}
+		start_cv_.notify_all();
+		for (auto& worker : workers_)
+		{
+			worker.join();
+		}
+	}
+
+	size_t ThreadPool::GetThreadsCount() const
+	{
+		return workers_.size() + 1;
+	}
+
+	void ThreadPool::Run(size_t tasks_count, const std::function<void(size_t)>& task)
+	{
+		if (tasks_count == 0)
+		{
+			return;
+		}
+		{
+			std::lock_guard lock(mutex_);
+			task_ = &task;
+			tasks_count_ = tasks_count;
+			next_task_ = 0;
+			active_workers_ = workers_.size();
+			exception_ = nullptr;
+			++generation_;
+		}
+		start_cv_.notify_all();
+
+		ProcessTasks();
+
+		std::unique_lock lock(mutex_);
+		done_cv_.wait(lock, [this] { return active_workers_ == 0; });
+		task_ = nullptr;
+		if (exception_)
+		{
+			std::rethrow_exception(std::exchange(exception_, nullptr));
+		}
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		size_t seen_generation = 0;
+		while (true)
+		{
+			{
+				std::unique_lock lock(mutex_);
+				start_cv_.wait(lock, [this, seen_generation] { return stop_ || generation_ != seen_generation; });
+				if (stop_)
+				{
+					return;
+				}
+				seen_generation = generation_;
+			}
+
+			ProcessTasks();
+
+			std::lock_guard lock(mutex_);
+			if (--active_workers_ == 0)
+			{
+				done_cv_.notify_all();
+			}
+		}
+	}
+
+	void ThreadPool::ProcessTasks()
+	{
+		for (size_t index = next_task_.fetch_add(1); index < tasks_count_; index = next_task_.fetch_add(1))
+		{
+			try
+			{
+				(*task_)(index);
+			}
+			catch (...)
+			{
+				std::lock_guard lock(mutex_);
+				if (!exception_)
+				{
+					exception_ = std::current_exception();
+				}
+			}
+		}
+	}
+} // namespace parallel
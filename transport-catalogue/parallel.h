@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace parallel
+{
+	// пул потоков для параллельной обработки набора независимых задач;
+	// вызывающий поток участвует в работе наравне с рабочими
+	class ThreadPool final
+	{
+	public:
+		// threads_count == 0 - по числу аппаратных потоков
+		explicit ThreadPool(size_t threads_count = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// число потоков, включая вызывающий
+		size_t GetThreadsCount() const;
+
+		// вызывает task(index) для каждого index из [0, tasks_count) и ждёт завершения всех задач;
+		// первое выброшенное задачей исключение пробрасывается вызывающему
+		void Run(size_t tasks_count, const std::function<void(size_t)>& task);
+
+		// делит [first, last) на куски не крупнее chunk_size и вызывает для каждого func(begin, end)
+		template <typename Func>
+		void ParallelFor(size_t first, size_t last, size_t chunk_size, Func func);
+
+	private:
+		void WorkerLoop();
+		void ProcessTasks();
+
+		std::vector<std::thread> workers_;
+		std::mutex mutex_;
+		std::condition_variable start_cv_;
+		std::condition_variable done_cv_;
+
+		const std::function<void(size_t)>* task_ = nullptr;
+		size_t tasks_count_ = 0;
+		std::atomic<size_t> next_task_{ 0 };
+		size_t active_workers_ = 0;
+		size_t generation_ = 0;
+		bool stop_ = false;
+		std::exception_ptr exception_;
+	};
+
+	template <typename Func>
+	void ThreadPool::ParallelFor(size_t first, size_t last, size_t chunk_size, Func func)
+	{
+		if (first >= last)
+		{
+			return;
+		}
+		chunk_size = std::max<size_t>(chunk_size, 1);
+		const size_t chunks_count = (last - first + chunk_size - 1) / chunk_size;
+		Run(chunks_count, [first, last, chunk_size, &func](size_t chunk)
+		{
+			const size_t begin = first + chunk * chunk_size;
+			func(begin, std::min(begin + chunk_size, last));
+		});
+	}
+} // namespace parallel
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -26,12 +27,68 @@ namespace ranges
 		{
 			return end_;
 		}
+		size_t size() const
+		{
+			return static_cast<size_t>(std::distance(begin_, end_));
+		}
+		bool empty() const
+		{
+			return begin_ == end_;
+		}
+		// только для итераторов произвольного доступа
+		decltype(auto) operator[](size_t index) const
+		{
+			return begin_[index];
+		}
 
 	private:
 		It begin_;
 		It end_;
 	};
 
+	// итератор по последовательным целым числам: диапазон номеров без хранения самих номеров
+	template <typename T>
+	class CountingIterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = T;
+
+		explicit CountingIterator(T value)
+			: value_(value)
+		{
+		}
+		T operator*() const
+		{
+			return value_;
+		}
+		CountingIterator& operator++()
+		{
+			++value_;
+			return *this;
+		}
+		CountingIterator operator++(int)
+		{
+			CountingIterator result = *this;
+			++value_;
+			return result;
+		}
+		bool operator==(const CountingIterator& other) const
+		{
+			return value_ == other.value_;
+		}
+		bool operator!=(const CountingIterator& other) const
+		{
+			return value_ != other.value_;
+		}
+
+	private:
+		T value_;
+	};
+
 	template <typename C>
 	auto AsRange(const C& container)
 	{
@@ -0,0 +1,286 @@
+#include "raptor.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace transport_catalogue
+{
+	RaptorRouter::RaptorRouter(const TransportCatalogue& catalogue, double wait_time, double velocity)
+		: wait_time_(wait_time)
+		, stops_count_(catalogue.GetStopCount())
+	{
+		for (const auto& [bus_name, bus] : catalogue.GetBusnameToBus())
+		{
+			AddRoute(catalogue, bus->id, false, velocity);
+			if (!bus->is_roundtrip)
+			{
+				AddRoute(catalogue, bus->id, true, velocity);
+			}
+		}
+
+		// индекс "остановка -> маршруты" в виде сжатых строк
+		stop_routes_offsets_.assign(stops_count_ + 1, 0);
+		for (const uint32_t stop : route_stops_)
+		{
+			++stop_routes_offsets_[stop + 1];
+		}
+		for (size_t stop = 0; stop < stops_count_; ++stop)
+		{
+			stop_routes_offsets_[stop + 1] += stop_routes_offsets_[stop];
+		}
+		stop_routes_.resize(route_stops_.size());
+		std::vector<size_t> next_slots(stop_routes_offsets_.begin(), stop_routes_offsets_.end() - 1);
+		for (uint32_t route = 0; route < routes_.size(); ++route)
+		{
+			for (uint32_t position = 0; position < routes_[route].stops_count; ++position)
+			{
+				const uint32_t stop = route_stops_[routes_[route].first_stop + position];
+				stop_routes_[next_slots[stop]++] = { route, position };
+			}
+		}
+	}
+
+	void RaptorRouter::AddRoute(const TransportCatalogue& catalogue, BusId bus_id, bool is_backward, double velocity)
+	{
+		const auto stops = catalogue.GetBusStops(bus_id);
+		const size_t stops_count = stops.size();
+		if (stops_count < 2)
+		{
+			return;
+		}
+		const auto stop_at = [&stops, stops_count, is_backward](size_t i)
+		{
+			return stops[is_backward ? stops_count - 1 - i : i];
+		};
+		routes_.push_back({ route_stops_.size(), stops_count, catalogue.GetBusName(bus_id) });
+		for (size_t i = 0; i < stops_count; ++i)
+		{
+			route_stops_.push_back(stop_at(i));
+			segment_times_.push_back(i + 1 < stops_count ? catalogue.GetDistance(stop_at(i), stop_at(i + 1)) / velocity : 0);
+		}
+	}
+
+	void RaptorRouter::CheckStop(size_t stop) const
+	{
+		if (stop >= stops_count_)
+		{
+			throw std::out_of_range("Stop id is out of range");
+		}
+	}
+
+	void RaptorRouter::AddRound(Rounds& rounds) const
+	{
+		if (rounds.count == rounds.arrivals.size())
+		{
+			rounds.arrivals.emplace_back();
+			rounds.labels.emplace_back();
+		}
+		auto& arrivals = rounds.arrivals[rounds.count];
+		if (rounds.count == 0)
+		{
+			arrivals.assign(stops_count_, UNREACHED);
+		}
+		else
+		{
+			arrivals = rounds.arrivals[rounds.count - 1];
+		}
+		rounds.labels[rounds.count].assign(stops_count_, Label{});
+		++rounds.count;
+	}
+
+	void RaptorRouter::Search(Rounds& rounds, size_t from, std::optional<size_t> target, size_t max_rounds,
+		double max_time) const
+	{
+		CheckStop(from);
+		rounds.count = 0;
+		AddRound(rounds);
+		rounds.arrivals[0][from] = 0;
+
+		auto& marked_stops = rounds.marked_stops;
+		auto& is_marked = rounds.is_marked;
+		// самая ранняя позиция улучшенной остановки на каждом маршруте раунда
+		auto& first_positions = rounds.first_positions;
+		auto& queued_routes = rounds.queued_routes;
+		marked_stops.assign(1, from);
+		is_marked.assign(stops_count_, false);
+		first_positions.assign(routes_.size(), NO_ROUTE);
+		queued_routes.clear();
+		while (!marked_stops.empty() && rounds.count <= max_rounds)
+		{
+			for (const size_t stop : marked_stops)
+			{
+				for (size_t i = stop_routes_offsets_[stop]; i < stop_routes_offsets_[stop + 1]; ++i)
+				{
+					const auto [route, position] = stop_routes_[i];
+					if (first_positions[route] == NO_ROUTE)
+					{
+						queued_routes.push_back(route);
+					}
+					first_positions[route] = std::min(first_positions[route], position);
+				}
+			}
+			marked_stops.clear();
+
+			AddRound(rounds);
+			const auto& previous_arrivals = rounds.arrivals[rounds.count - 2];
+			auto& arrivals = rounds.arrivals[rounds.count - 1];
+			auto& labels = rounds.labels[rounds.count - 1];
+			for (const uint32_t route : queued_routes)
+			{
+				const size_t first_stop = routes_[route].first_stop;
+				const uint32_t stops_count = static_cast<uint32_t>(routes_[route].stops_count);
+				double time_on_board = UNREACHED;
+				uint32_t board_position = 0;
+				for (uint32_t position = first_positions[route]; position < stops_count; ++position)
+				{
+					const uint32_t stop = route_stops_[first_stop + position];
+					const double best_time = target ? std::min(arrivals[stop], arrivals[*target]) : arrivals[stop];
+					if (time_on_board < best_time && time_on_board <= max_time)
+					{
+						arrivals[stop] = time_on_board;
+						labels[stop] = { route, board_position, position };
+						if (!is_marked[stop])
+						{
+							is_marked[stop] = true;
+							marked_stops.push_back(stop);
+						}
+					}
+					// пересесть на этот автобус здесь выгоднее, чем ехать с прежней посадки
+					if (previous_arrivals[stop] + wait_time_ < time_on_board)
+					{
+						time_on_board = previous_arrivals[stop] + wait_time_;
+						board_position = position;
+					}
+					time_on_board += segment_times_[first_stop + position];
+				}
+				first_positions[route] = NO_ROUTE;
+			}
+			queued_routes.clear();
+			for (const size_t stop : marked_stops)
+			{
+				is_marked[stop] = false;
+			}
+		}
+	}
+
+	std::optional<RaptorRouter::Journey> RaptorRouter::ExtractJourney(const Rounds& rounds, size_t from, size_t to,
+		size_t round) const
+	{
+		CheckStop(to);
+		if (rounds.arrivals[round][to] == UNREACHED)
+		{
+			return std::nullopt;
+		}
+		Journey journey;
+		size_t stop = to;
+		for (; stop != from; --round)
+		{
+			// метка раунда задана, только если он улучшил время; иначе оно унаследовано
+			const Label& label = rounds.labels[round][stop];
+			if (label.route == NO_ROUTE)
+			{
+				continue;
+			}
+			const Route& route = routes_[label.route];
+			const size_t board_stop = route_stops_[route.first_stop + label.board_position];
+			Ride ride;
+			ride.bus_name = route.bus_name;
+			ride.stop_from = board_stop;
+			ride.stop_to = stop;
+			// время складывается в том же порядке, что и вес ребра графа: разность времён
+			// прибытия отличалась бы от него в последних знаках
+			ride.total_time = wait_time_;
+			for (uint32_t position = label.board_position; position < label.alight_position; ++position)
+			{
+				ride.total_time += segment_times_[route.first_stop + position];
+			}
+			ride.span_count = static_cast<int>(label.alight_position - label.board_position);
+			journey.push_back(ride);
+			stop = board_stop;
+		}
+		std::reverse(journey.begin(), journey.end());
+		return journey;
+	}
+
+	std::optional<RaptorRouter::Journey> RaptorRouter::ExtractJourney(const Rounds& rounds, size_t from, size_t to) const
+	{
+		return ExtractJourney(rounds, from, to, rounds.count - 1);
+	}
+
+	std::optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(size_t from, size_t to) const
+	{
+		CheckStop(to);
+		auto rounds = rounds_pool_.Acquire();
+		Search(*rounds, from, to);
+		return ExtractJourney(*rounds, from, to);
+	}
+
+	std::vector<std::optional<RaptorRouter::Journey>> RaptorRouter::BuildRoutes(size_t from,
+		const std::vector<size_t>& targets) const
+	{
+		auto rounds = rounds_pool_.Acquire();
+		Search(*rounds, from, std::nullopt);
+		std::vector<std::optional<Journey>> result;
+		result.reserve(targets.size());
+		for (const size_t to : targets)
+		{
+			result.push_back(ExtractJourney(*rounds, from, to));
+		}
+		return result;
+	}
+
+	std::vector<std::optional<double>> RaptorRouter::ComputeDurations(size_t from, const std::vector<size_t>& targets) const
+	{
+		auto rounds = rounds_pool_.Acquire();
+		Search(*rounds, from, std::nullopt);
+		const auto& arrivals = rounds->arrivals[rounds->count - 1];
+		std::vector<std::optional<double>> result;
+		result.reserve(targets.size());
+		for (const size_t to : targets)
+		{
+			CheckStop(to);
+			result.push_back(arrivals[to] != UNREACHED ? std::optional<double>(arrivals[to]) : std::nullopt);
+		}
+		return result;
+	}
+
+	std::vector<RaptorRouter::Journey> RaptorRouter::BuildParetoRoutes(size_t from, size_t to, size_t max_boardings) const
+	{
+		CheckStop(to);
+		auto rounds = rounds_pool_.Acquire();
+		Search(*rounds, from, to, max_boardings);
+
+		// раунд k улучшает время цели, только если k посадок дают более быструю поездку,
+		// чем любое меньшее их число; такие поездки и образуют фронт Парето
+		std::vector<Journey> result;
+		for (size_t round = 0; round < rounds->count; ++round)
+		{
+			const double arrival = rounds->arrivals[round][to];
+			if (arrival != UNREACHED && (round == 0 || arrival < rounds->arrivals[round - 1][to]))
+			{
+				result.push_back(*ExtractJourney(*rounds, from, to, round));
+			}
+		}
+		return result;
+	}
+
+	std::vector<std::pair<size_t, double>> RaptorRouter::ComputeReachable(size_t from, double max_time) const
+	{
+		auto rounds = rounds_pool_.Acquire();
+		Search(*rounds, from, std::nullopt, std::numeric_limits<size_t>::max(), max_time);
+		const auto& arrivals = rounds->arrivals[rounds->count - 1];
+		std::vector<std::pair<size_t, double>> result;
+		for (size_t stop = 0; stop < stops_count_; ++stop)
+		{
+			if (arrivals[stop] <= max_time)
+			{
+				result.emplace_back(stop, arrivals[stop]);
+			}
+		}
+		std::stable_sort(result.begin(), result.end(), [](const auto& left, const auto& right)
+		{
+			return left.second < right.second;
+		});
+		return result;
+	}
+} // namespace transport_catalogue
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "search_state.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue
+{
+	// RAPTOR: поиск по раундам прямо по последовательностям остановок автобусов без
+	// предварительных вычислений. Раунд k находит лучшие времена прибытия не более чем
+	// с k поездками, просматривая только маршруты через остановки, улучшенные в раунде k - 1.
+	// Ожидание автобуса - стоимость каждой посадки
+	class RaptorRouter final
+	{
+	public:
+		// одна поездка на автобусе; остановки заданы номерами, как в TransportRouter
+		struct Ride
+		{
+			std::string_view bus_name;
+			size_t stop_from = 0;
+			size_t stop_to = 0;
+			double total_time = 0;  // ожидание и проезд
+			int span_count = 0;
+		};
+		using Journey = std::vector<Ride>;
+
+		// номера остановок в запросах и ответах - номера остановок справочника
+		RaptorRouter(const TransportCatalogue& catalogue, double wait_time, double velocity);
+
+		std::optional<Journey> BuildRoute(size_t from, size_t to) const;
+		// все цели по одному поиску из from; ответ i соответствует targets[i]
+		std::vector<std::optional<Journey>> BuildRoutes(size_t from, const std::vector<size_t>& targets) const;
+		std::vector<std::optional<double>> ComputeDurations(size_t from, const std::vector<size_t>& targets) const;
+
+		// Парето-оптимальные поездки по времени и числу посадок, не более max_boardings посадок:
+		// по одной на каждое число посадок, которое сокращает время. Упорядочены по числу посадок
+		std::vector<Journey> BuildParetoRoutes(size_t from, size_t to, size_t max_boardings) const;
+
+		// остановки, достижимые из from не дольше чем за max_time, и время до них по возрастанию.
+		// Поиск отсекает метки за пределами бюджета, но массивы раундов занимают O(числа остановок)
+		std::vector<std::pair<size_t, double>> ComputeReachable(size_t from, double max_time) const;
+
+	private:
+		static constexpr uint32_t NO_ROUTE = std::numeric_limits<uint32_t>::max();
+		static constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+
+		// маршрут - одно направление движения автобуса: остановки route_stops_[first_stop, first_stop + stops_count)
+		struct Route
+		{
+			size_t first_stop = 0;
+			size_t stops_count = 0;
+			std::string_view bus_name;
+		};
+
+		// маршрут через остановку и позиция остановки в нём
+		struct StopRoute
+		{
+			uint32_t route = 0;
+			uint32_t position = 0;
+		};
+
+		// как получено время прибытия раунда: поездка по маршруту между позициями остановок
+		struct Label
+		{
+			uint32_t route = NO_ROUTE;
+			uint32_t board_position = 0;
+			uint32_t alight_position = 0;
+		};
+
+		// Времена прибытия и метки по раундам; раунд k начинается с копии раунда k - 1, так что
+		// у остановки не больше одной метки на раунд. Память переиспользуется между запросами
+		// через пул: заполнены первые count раундов
+		struct Rounds
+		{
+			std::vector<std::vector<double>> arrivals;
+			std::vector<std::vector<Label>> labels;
+			size_t count = 0;
+
+			// рабочие массивы просмотра маршрутов
+			std::vector<size_t> marked_stops;
+			std::vector<bool> is_marked;
+			std::vector<uint32_t> first_positions;
+			std::vector<uint32_t> queued_routes;
+		};
+
+		// маршрут по остановкам автобуса из снимка справочника, при is_backward - в обратном порядке
+		void AddRoute(const TransportCatalogue& catalogue, BusId bus_id, bool is_backward, double velocity);
+		void CheckStop(size_t stop) const;
+
+		// target задаёт отсечение по времени цели; без него считаются все остановки.
+		// max_rounds ограничивает число посадок, max_time - время в пути
+		void Search(Rounds& rounds, size_t from, std::optional<size_t> target,
+			size_t max_rounds = std::numeric_limits<size_t>::max(), double max_time = UNREACHED) const;
+		void AddRound(Rounds& rounds) const;
+		// поездка до to с числом посадок не больше round
+		std::optional<Journey> ExtractJourney(const Rounds& rounds, size_t from, size_t to, size_t round) const;
+		std::optional<Journey> ExtractJourney(const Rounds& rounds, size_t from, size_t to) const;
+
+		double wait_time_ = 0;
+		size_t stops_count_ = 0;
+		std::vector<Route> routes_;
+		// номера остановок всех маршрутов подряд и время проезда от каждой до следующей по маршруту
+		std::vector<uint32_t> route_stops_;
+		std::vector<double> segment_times_;
+		// маршруты через остановку s: stop_routes_[stop_routes_offsets_[s], stop_routes_offsets_[s + 1])
+		std::vector<size_t> stop_routes_offsets_;
+		std::vector<StopRoute> stop_routes_;
+
+		mutable graph::StatePool<Rounds> rounds_pool_;
+	};
+} // namespace transport_catalogue
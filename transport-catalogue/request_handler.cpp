@@ -1,5 +1,6 @@
 #include <fstream>
 #include <memory>
+#include <stdexcept>
 
 #include "request_handler.h"
 
@@ -7,6 +8,14 @@ using namespace std::literals;
 
 namespace transport_catalogue
 {
+	namespace detail
+	{
+		void PrintProgress(size_t done, size_t total)
+		{
+			std::cerr << "Precomputing routes: "s << done << " / "s << total << std::endl;
+		}
+	} // namespace detail
+
 	bool TransportCatalogueHandler::InitRouter()
 	{
 		if (!router_)
@@ -16,12 +25,21 @@ namespace transport_catalogue
 		return true;
 	}
 
-	void TransportCatalogueHandler::LoadDataFromJson(JsonReader& json)
+	bool TransportCatalogueHandler::LoadDataFromJson(JsonReader& json)
 	{
 		json.ReadRequests();
 		render_settings_ = json.LoadRenderSettings();
 		serialize_settings_ = json.LoadSerializeSettings();
-		routing_settings_ = json.LoadRoutingSettings();
+		try
+		{
+			routing_settings_ = json.LoadRoutingSettings();
+		}
+		catch (const std::invalid_argument& error)
+		{
+			std::cerr << "Invalid routing settings: "s << error.what() << std::endl;
+			return false;
+		}
+		return true;
 	}
 
 	void TransportCatalogueHandler::LoadSerializeSettings(JsonReader& json)
@@ -31,12 +49,12 @@ namespace transport_catalogue
 
 	void TransportCatalogueHandler::LoadRequestsAndAnswer(JsonReader& json)
 	{
+		// без маршрутизатора отвечаем на все запросы, кроме запросов маршрутов
 		if (!InitRouter())
 		{
 			std::cerr << "Can't init Transport Router"s << std::endl;
-			return;
 		}
-		json.GenerateOutput(render_settings_.value(), *router_);
+		json.GenerateOutput(render_settings_.value(), router_.get());
 	}
 
 	bool TransportCatalogueHandler::SerializeData()
@@ -55,7 +73,7 @@ namespace transport_catalogue
 		if (routing_settings_)
 		{
 			InitRouter();
-			router_->InitRouter();
+			router_->InitRouter(detail::PrintProgress);
 			serializator.AddTransportRouter(*router_.get());
 		}
 		return serializator.Serialize();
@@ -80,6 +98,26 @@ namespace transport_catalogue
 		return false;
 	}
 
+	bool TransportCatalogueHandler::UpdateData(JsonReader& json)
+	{
+		auto changed_buses = json.ApplyBaseUpdates();
+		if (!changed_buses)
+		{
+			std::cerr << "Can't apply base updates"s << std::endl;
+			return false;
+		}
+		if (router_)
+		{
+			const auto statistics = router_->UpdateBuses(*changed_buses, detail::PrintProgress);
+			std::cerr << "Updated buses: "s << changed_buses->size()
+				<< ", removed edges: "s << statistics.removed_edges
+				<< ", added edges: "s << statistics.added_edges
+				<< ", repaired rows: "s << statistics.repaired_rows
+				<< (statistics.is_rebuilt ? ", graph rebuilt"s : ""s) << std::endl;
+		}
+		return SerializeData();
+	}
+
 	bool TransportCatalogueHandler::ReInitRouter()
 	{
 		if (routing_settings_)
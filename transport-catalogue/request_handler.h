@@ -21,7 +21,8 @@ namespace transport_catalogue
 		explicit TransportCatalogueHandler(TransportCatalogue& catalogue)
 			: catalogue_(catalogue) {}
 
-		void LoadDataFromJson(JsonReader& json);
+		// false, если настройки заданы с ошибкой
+		bool LoadDataFromJson(JsonReader& json);
 
 		void LoadSerializeSettings(JsonReader& json);
 
@@ -31,6 +32,9 @@ namespace transport_catalogue
 
 		bool DeserializeData();
 
+		// применяет изменения автобусов из json к загруженной базе и сохраняет её заново
+		bool UpdateData(JsonReader& json);
+
 		bool ReInitRouter();
 
 	private:
@@ -1,11 +1,18 @@
 #pragma once
 
-#include "graph.h"
+#include "frozen_graph.h"
+#include "parallel.h"
+#include "search_state.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,14 +21,62 @@
 
 namespace graph
 {
+	// способ предрасчёта матрицы маршрутов между всеми парами вершин
+	enum class PrecomputeMethod
+	{
+		FLOYD_WARSHALL,  // O(V³), не зависит от числа рёбер
+		DIJKSTRA,        // поиск из каждой вершины, O(V·E·log V): быстрее на разреженных графах
+	};
+
+	// сообщает о ходе долгого предрасчёта: выполнено done шагов из total.
+	// Вызовы не пересекаются по времени, но могут приходить из разных потоков
+	using ProgressCallback = std::function<void(size_t done, size_t total)>;
+
 	template <typename Weight>
 	class Router
 	{
 	private:
-		using Graph = DirectedWeightedGraph<Weight>;
+		using Graph = FrozenGraph<Weight>;
+		using Key = typename WeightTraits<Weight>::Key;
 
 	public:
-		explicit Router(const Graph& graph, bool initialize = true);
+		// плотная матрица маршрутов в одном выделении на массив: для пары (from, to) в ячейке
+		// row(from) * vertex_count + to хранятся вес пути и последнее ребро пути.
+		// Путь существует, если from == to или последнее ребро задано. Строки есть у всех
+		// вершин (row(from) == from) либо только у вершин-источников sources, по порядку
+		struct RoutesInternalData
+		{
+			size_t vertex_count = 0;
+			std::vector<Key> weights;
+			std::vector<uint32_t> prev_edges;
+			std::vector<uint32_t> sources;
+		};
+
+		// та же матрица без владения данными: собственные массивы маршрутизатора
+		// или внешняя память, например отображённый в память файл базы.
+		// sources == nullptr - строки всех вершин, иначе rows_count строк источников
+		struct RoutesView
+		{
+			size_t vertex_count = 0;
+			const Key* weights = nullptr;
+			const uint32_t* prev_edges = nullptr;
+			size_t rows_count = 0;
+			const uint32_t* sources = nullptr;
+		};
+
+		// threads_count == 0 - предрасчёт использует все аппаратные потоки
+		explicit Router(const Graph& graph, bool initialize = true, size_t threads_count = 0,
+			PrecomputeMethod method = PrecomputeMethod::FLOYD_WARSHALL, ProgressCallback progress = nullptr);
+		// строки только для вершин sources: память O(|sources|·V) вместо O(V²).
+		// Строки считаются поиском Дейкстры из каждого источника
+		Router(const Graph& graph, const std::vector<VertexId>& sources, size_t threads_count = 0,
+			ProgressCallback progress = nullptr);
+		// использует готовую матрицу во внешней памяти без копирования; storage продлевает её жизнь.
+		// Список источников копируется, его память нужна только на время вызова
+		Router(const Graph& graph, RoutesView routes, std::shared_ptr<const void> storage);
+
+		Router(const Router&) = delete;
+		Router& operator=(const Router&) = delete;
 
 		struct RouteInfo
 		{
@@ -29,118 +84,538 @@ namespace graph
 			std::vector<EdgeId> edges;
 		};
 
+		// есть ли у from предрасчитанная строка; без неё BuildRoute из from не отвечает
+		bool HasRow(VertexId from) const
+		{
+			return from < routes_.vertex_count && (!routes_.sources || row_by_vertex_[from] != NO_ROW);
+		}
+
 		std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
-		struct RouteInternalData
-		{
-			Weight weight;
-			std::optional<EdgeId> prev_edge;
-		};
-		using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+		// Приводит матрицу в соответствие с графом после того, как в нём заменили часть рёбер.
+		// new_edge_ids[e] - номер ребра e прежнего графа в новом либо NO_EDGE, если ребро удалено;
+		// рёбра нового графа, в которые ничего не отображается, считаются добавленными. Новые
+		// вершины допускаются только в конце; вершина, потерявшая все рёбра, может получить
+		// новые, и её строка и столбец чинятся как остальные. Заново поиском Дейкстры считаются лишь строки,
+		// где путь шёл по удалённому ребру или где новое ребро сокращает путь; в остальных
+		// меняются только номера рёбер. Возвращает число пересчитанных строк
+		size_t Repair(const std::vector<EdgeId>& new_edge_ids, size_t threads_count = 0, ProgressCallback progress = nullptr);
+
+		// отметка "последнего ребра нет": путь из вершины в неё саму либо пути нет вовсе
+		static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
 
 	private:
+		static constexpr uint32_t NO_ROW = std::numeric_limits<uint32_t>::max();
+		// состояние пути вершины при починке строки
+		enum : char { UNKNOWN_VERTEX, KEPT_VERTEX, CUT_VERTEX };
+
+		size_t GetRow(VertexId from) const
+		{
+			return routes_.sources ? row_by_vertex_[from] : from;
+		}
+
+		bool HasRoute(size_t row, VertexId from, VertexId to) const
+		{
+			return from == to || routes_.prev_edges[row * routes_.vertex_count + to] != NO_EDGE;
+		}
+
+		bool HasComputedRoute(VertexId from, VertexId to) const
+		{
+			return from == to || routes_internal_data_.prev_edges[from * routes_internal_data_.vertex_count + to] != NO_EDGE;
+		}
+
+		void UseOwnRoutesInternalData(bool has_sources)
+		{
+			const auto& sources = routes_internal_data_.sources;
+			routes_ = RoutesView{ routes_internal_data_.vertex_count,
+				routes_internal_data_.weights.data(), routes_internal_data_.prev_edges.data(),
+				has_sources ? sources.size() : routes_internal_data_.vertex_count, has_sources ? sources.data() : nullptr };
+		}
+
+		// номер строки каждой вершины-источника; проверяет, что источники различны
+		void IndexSources(const uint32_t* sources, size_t rows_count, size_t vertex_count)
+		{
+			row_by_vertex_.assign(vertex_count, NO_ROW);
+			for (size_t row = 0; row < rows_count; ++row)
+			{
+				if (sources[row] >= vertex_count || row_by_vertex_[sources[row]] != NO_ROW)
+				{
+					throw std::invalid_argument("Route sources should be distinct vertices");
+				}
+				row_by_vertex_[sources[row]] = static_cast<uint32_t>(row);
+			}
+		}
+
+		static void CheckEdges(const Graph& graph)
+		{
+			if (graph.GetEdgeCount() >= NO_EDGE)
+			{
+				throw std::length_error("Too many edges for the routes matrix");
+			}
+			for (const Key& key : graph.GetKeys())
+			{
+				if (key < ZERO_KEY)
+				{
+					throw std::domain_error("Edges' weights should be non-negative");
+				}
+			}
+		}
+
 		void InitializeRoutesInternalData(const Graph& graph)
 		{
 			const size_t vertex_count = graph.GetVertexCount();
+			auto& weights = routes_internal_data_.weights;
+			auto& prev_edges = routes_internal_data_.prev_edges;
 			for (VertexId vertex = 0; vertex < vertex_count; ++vertex)
 			{
-				routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+				weights[vertex * vertex_count + vertex] = ZERO_KEY;
 				for (const EdgeId edge_id : graph.GetIncidentEdges(vertex))
 				{
-					const auto& edge = graph.GetEdge(edge_id);
-					if (edge.weight < ZERO_WEIGHT)
+					const VertexId vertex_to = graph.GetEdgeTarget(edge_id);
+					const Key edge_key = graph.GetEdgeKey(edge_id);
+					const size_t cell = vertex * vertex_count + vertex_to;
+					if (!HasComputedRoute(vertex, vertex_to) || weights[cell] > edge_key)
+					{
+						weights[cell] = edge_key;
+						prev_edges[cell] = static_cast<uint32_t>(edge_id);
+					}
+				}
+			}
+		}
+
+		// Флойд-Уоршелл над плоской матрицей V x V. Шаги по промежуточной вершине идут
+		// последовательно, а строки матрицы на каждом шаге обрабатываются параллельно блоками,
+		// поэтому порядок релаксаций каждой ячейки совпадает с последовательным алгоритмом
+		void ComputeRoutesInternalData(const Graph& graph, size_t threads_count, const ProgressCallback& progress)
+		{
+			const size_t vertex_count = graph.GetVertexCount();
+			auto& weights = routes_internal_data_.weights;
+			auto& prev_edges = routes_internal_data_.prev_edges;
+
+			parallel::ThreadPool pool(threads_count);
+			for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through)
+			{
+				const size_t through_row = vertex_through * vertex_count;
+				pool.ParallelFor(0, vertex_count, ROWS_PER_TASK, [&](size_t rows_begin, size_t rows_end)
+				{
+					for (VertexId vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from)
 					{
-						throw std::domain_error("Edges' weights should be non-negative");
+						// строка промежуточной вершины на её шаге не меняется: путь через неё же не короче
+						const size_t from_row = vertex_from * vertex_count;
+						if (vertex_from == vertex_through || !HasComputedRoute(vertex_from, vertex_through))
+						{
+							continue;
+						}
+						const Key weight_from = weights[from_row + vertex_through];
+						const uint32_t prev_edge_from = prev_edges[from_row + vertex_through];
+						for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to)
+						{
+							const size_t cell_to = through_row + vertex_to;
+							const uint32_t prev_edge_to = prev_edges[cell_to];
+							if (prev_edge_to == NO_EDGE && vertex_to != vertex_through)
+							{
+								continue;
+							}
+							const size_t cell = from_row + vertex_to;
+							const Key candidate_weight = weight_from + weights[cell_to];
+							if (!HasComputedRoute(vertex_from, vertex_to) || candidate_weight < weights[cell])
+							{
+								weights[cell] = candidate_weight;
+								prev_edges[cell] = prev_edge_to != NO_EDGE ? prev_edge_to : prev_edge_from;
+							}
+						}
 					}
-					auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-					if (!route_internal_data || route_internal_data->weight > edge.weight)
+				});
+				ReportProgress(progress, vertex_through, vertex_through + 1, vertex_count);
+			}
+		}
+
+		// Строка from матрицы - дерево кратчайших путей из from, поэтому строки независимы
+		// и считаются параллельно поиском Дейкстры. Каждая задача берёт из пула своё
+		// состояние поиска, так что куча и рабочие массивы переиспользуются внутри потока.
+		// Считаются rows_count строк: rows[i] либо, без rows, строки по порядку. Источник строки -
+		// sources[row] либо, если источников нет, вершина с номером строки
+		void ComputeRoutesByDijkstra(const Graph& graph, size_t rows_count, const uint32_t* sources, size_t threads_count,
+			const ProgressCallback& progress, const size_t* rows = nullptr)
+		{
+			SearchStatePool<Key> states_pool;
+			size_t rows_done = 0;
+			std::mutex progress_mutex;
+
+			parallel::ThreadPool pool(threads_count);
+			pool.ParallelFor(0, rows_count, ROWS_PER_TASK, [&](size_t rows_begin, size_t rows_end)
+			{
+				auto state = states_pool.Acquire();
+				for (size_t task = rows_begin; task < rows_end; ++task)
+				{
+					const size_t row = rows ? rows[task] : task;
+					ComputeRow(graph, sources ? sources[row] : row, row, *state);
+				}
+				std::lock_guard lock(progress_mutex);
+				ReportProgress(progress, rows_done, rows_done + rows_end - rows_begin, rows_count);
+				rows_done += rows_end - rows_begin;
+			});
+		}
+
+		void ComputeRow(const Graph& graph, VertexId vertex_from, size_t row, SearchState<Key>& state)
+		{
+			const size_t vertex_count = graph.GetVertexCount();
+			state.Reset(vertex_count);
+			state.Reach(vertex_from, ZERO_KEY, SearchState<Key>::NO_EDGE);
+			state.Push(ZERO_KEY, ZERO_KEY, vertex_from);
+			Key* weights = routes_internal_data_.weights.data() + row * vertex_count;
+			uint32_t* prev_edges = routes_internal_data_.prev_edges.data() + row * vertex_count;
+			while (!state.IsQueueEmpty())
+			{
+				const auto item = state.Pop();
+				if (state.GetWeight(item.vertex) < item.weight)
+				{
+					continue;
+				}
+				// вершина окончательно обработана: её вес и последнее ребро больше не изменятся
+				weights[item.vertex] = item.weight;
+				if (item.vertex != vertex_from)
+				{
+					prev_edges[item.vertex] = static_cast<uint32_t>(state.GetPrevEdge(item.vertex));
+				}
+				for (const EdgeId edge_id : graph.GetIncidentEdges(item.vertex))
+				{
+					const VertexId next_vertex = graph.GetEdgeTarget(edge_id);
+					const Key candidate_weight = item.weight + graph.GetEdgeKey(edge_id);
+					if (!state.IsReached(next_vertex) || candidate_weight < state.GetWeight(next_vertex))
 					{
-						route_internal_data = RouteInternalData{ edge.weight, edge_id };
+						state.Reach(next_vertex, candidate_weight, edge_id);
+						state.Push(candidate_weight, candidate_weight, next_vertex);
 					}
 				}
 			}
 		}
 
-		void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-			const RouteInternalData& route_to)
+		// Убирает из строки source пути, проходившие по удалённым рёбрам: после перенумерации
+		// у таких рёбер prev_edges равно NO_EDGE при заданном old_prev_edges. Путь вершины цел,
+		// если цел путь до начала её последнего ребра. Вершины с оборванным путём отмечаются
+		// в statuses как CUT_VERTEX и становятся недостижимыми
+		void CutRemovedPaths(VertexId source, size_t old_vertex_count, const uint32_t* old_prev_edges,
+			Key* weights, uint32_t* prev_edges, std::vector<char>& statuses) const
 		{
-			auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-			const Weight candidate_weight = route_from.weight + route_to.weight;
-			if (!route_relaxing || candidate_weight < route_relaxing->weight)
+			statuses.assign(old_vertex_count, KEPT_VERTEX);
+			for (VertexId vertex = 0; vertex < old_vertex_count; ++vertex)
+			{
+				if (vertex != source && old_prev_edges[vertex] != NO_EDGE)
+				{
+					statuses[vertex] = UNKNOWN_VERTEX;
+				}
+			}
+			// ответ протягивается по всей пройденной цепочке, так что каждая вершина разбирается один раз
+			std::vector<VertexId> chain;
+			for (VertexId vertex = 0; vertex < old_vertex_count; ++vertex)
+			{
+				VertexId current = vertex;
+				chain.clear();
+				while (statuses[current] == UNKNOWN_VERTEX)
+				{
+					if (prev_edges[current] == NO_EDGE || chain.size() > old_vertex_count)
+					{
+						statuses[current] = CUT_VERTEX;
+						break;
+					}
+					chain.push_back(current);
+					current = graph_.GetEdgeSource(prev_edges[current]);
+				}
+				for (const VertexId chain_vertex : chain)
+				{
+					statuses[chain_vertex] = statuses[current];
+				}
+			}
+			for (VertexId vertex = 0; vertex < old_vertex_count; ++vertex)
 			{
-				route_relaxing = { candidate_weight,
-								  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+				if (statuses[vertex] == CUT_VERTEX)
+				{
+					weights[vertex] = ZERO_KEY;
+					prev_edges[vertex] = NO_EDGE;
+				}
 			}
 		}
 
-		void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through)
+		// Доводит строку source до кратчайших путей в новом графе. После CutRemovedPaths каждое
+		// значение строки - вес существующего пути, то есть оценка сверху; нарушить её могут
+		// только рёбра, ведущие в отрезанные вершины, и добавленные рёбра. С них начинается поиск
+		// Дейкстры, который идёт дальше лишь там, где вес действительно уменьшается, поэтому
+		// работа пропорциональна изменившейся части дерева. Возвращает true, если строка изменилась
+		bool RepairRow(VertexId source, size_t old_vertex_count, const std::vector<EdgeId>& added_edges,
+			const std::vector<char>& statuses,
+			Key* weights, uint32_t* prev_edges, SearchState<Key>& state) const
 		{
-			for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from)
+			auto is_reached = [source, prev_edges](VertexId vertex)
 			{
-				if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through])
+				return vertex == source || prev_edges[vertex] != NO_EDGE;
+			};
+			auto relax = [&](EdgeId edge_id)
+			{
+				const VertexId vertex_from = graph_.GetEdgeSource(edge_id);
+				const VertexId vertex_to = graph_.GetEdgeTarget(edge_id);
+				if (!is_reached(vertex_from))
+				{
+					return;
+				}
+				const Key candidate_weight = weights[vertex_from] + graph_.GetEdgeKey(edge_id);
+				if (!is_reached(vertex_to) || candidate_weight < weights[vertex_to])
 				{
-					for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to)
+					weights[vertex_to] = candidate_weight;
+					prev_edges[vertex_to] = static_cast<uint32_t>(edge_id);
+					state.Push(candidate_weight, candidate_weight, vertex_to);
+				}
+			};
+
+			state.Reset(graph_.GetVertexCount());
+			bool is_changed = false;
+			for (VertexId vertex = 0; vertex < old_vertex_count; ++vertex)
+			{
+				if (statuses[vertex] == CUT_VERTEX)
+				{
+					is_changed = true;
+					for (const EdgeId edge_id : graph_.GetIncomingEdges(vertex))
 					{
-						if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to])
-						{
-							RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-						}
+						relax(edge_id);
 					}
 				}
 			}
+			for (const EdgeId edge_id : added_edges)
+			{
+				relax(edge_id);
+			}
+			is_changed = is_changed || !state.IsQueueEmpty();
+			while (!state.IsQueueEmpty())
+			{
+				const auto item = state.Pop();
+				if (weights[item.vertex] < item.weight)
+				{
+					continue;
+				}
+				for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex))
+				{
+					relax(edge_id);
+				}
+			}
+			return is_changed;
 		}
 
-		static constexpr Weight ZERO_WEIGHT{};
+		// выполнение продвинулось с done_before до done шагов; отчёт не чаще раза на процент,
+		// чтобы не тормозить предрасчёт
+		static void ReportProgress(const ProgressCallback& progress, size_t done_before, size_t done, size_t total)
+		{
+			if (progress && (done == total || done * 100 / total != done_before * 100 / total))
+			{
+				progress(done, total);
+			}
+		}
+
+		// сколько строк матрицы обрабатывает одна задача пула потоков
+		static constexpr size_t ROWS_PER_TASK = 16;
+
+		static constexpr Key ZERO_KEY{};
 		const Graph& graph_;
 		RoutesInternalData routes_internal_data_;
+		RoutesView routes_;
+		// строка каждой вершины при неполной матрице, NO_ROW - строки нет
+		std::vector<uint32_t> row_by_vertex_;
+		std::shared_ptr<const void> storage_;
 	public:
 
-		RoutesInternalData& GetRoutesInternalData()
+		// матрица, по которой отвечает маршрутизатор, независимо от того, где лежат данные
+		const RoutesView& GetRoutes() const
 		{
-			return routes_internal_data_;
-		}
-		const RoutesInternalData& GetRoutesInternalData() const
-		{
-			return routes_internal_data_;
+			return routes_;
 		}
 	};
 
 	template <typename Weight>
-	Router<Weight>::Router(const Graph& graph, bool initialize)
+	Router<Weight>::Router(const Graph& graph, bool initialize, size_t threads_count, PrecomputeMethod method,
+		ProgressCallback progress)
 		: graph_(graph)
-		, routes_internal_data_(graph.GetVertexCount(),
-			std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 	{
+		const size_t vertex_count = graph.GetVertexCount();
+		routes_internal_data_.vertex_count = vertex_count;
+		routes_internal_data_.weights.assign(vertex_count * vertex_count, ZERO_KEY);
+		routes_internal_data_.prev_edges.assign(vertex_count * vertex_count, NO_EDGE);
 		if (initialize)
 		{
-			InitializeRoutesInternalData(graph);
-			const size_t vertex_count = graph.GetVertexCount();
-			for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through)
+			CheckEdges(graph);
+			if (method == PrecomputeMethod::DIJKSTRA)
+			{
+				ComputeRoutesByDijkstra(graph, vertex_count, nullptr, threads_count, progress);
+			}
+			else
 			{
-				RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+				InitializeRoutesInternalData(graph);
+				ComputeRoutesInternalData(graph, threads_count, progress);
 			}
 		}
+		UseOwnRoutesInternalData(false);
+	}
+
+	template <typename Weight>
+	Router<Weight>::Router(const Graph& graph, const std::vector<VertexId>& sources, size_t threads_count,
+		ProgressCallback progress)
+		: graph_(graph)
+	{
+		if (sources.empty())
+		{
+			throw std::invalid_argument("Route sources should not be empty");
+		}
+		const size_t vertex_count = graph.GetVertexCount();
+		auto& data = routes_internal_data_;
+		data.vertex_count = vertex_count;
+		data.sources.assign(sources.begin(), sources.end());
+		IndexSources(data.sources.data(), data.sources.size(), vertex_count);
+		data.weights.assign(data.sources.size() * vertex_count, ZERO_KEY);
+		data.prev_edges.assign(data.sources.size() * vertex_count, NO_EDGE);
+		CheckEdges(graph);
+		ComputeRoutesByDijkstra(graph, data.sources.size(), data.sources.data(), threads_count, progress);
+		UseOwnRoutesInternalData(true);
+	}
+
+	template <typename Weight>
+	Router<Weight>::Router(const Graph& graph, RoutesView routes, std::shared_ptr<const void> storage)
+		: graph_(graph)
+		, routes_(routes)
+		, storage_(std::move(storage))
+	{
+		if (routes_.vertex_count != graph.GetVertexCount())
+		{
+			throw std::invalid_argument("Routes matrix size should match vertex count");
+		}
+		if (routes_.sources)
+		{
+			routes_internal_data_.sources.assign(routes_.sources, routes_.sources + routes_.rows_count);
+			routes_.sources = routes_internal_data_.sources.data();
+			IndexSources(routes_.sources, routes_.rows_count, routes_.vertex_count);
+		}
+		else
+		{
+			routes_.rows_count = routes_.vertex_count;
+		}
+	}
+
+	template <typename Weight>
+	size_t Router<Weight>::Repair(const std::vector<EdgeId>& new_edge_ids, size_t threads_count, ProgressCallback progress)
+	{
+		const size_t old_vertex_count = routes_.vertex_count;
+		const size_t vertex_count = graph_.GetVertexCount();
+		if (vertex_count < old_vertex_count)
+		{
+			throw std::invalid_argument("Vertices can't be removed from the routes matrix");
+		}
+		CheckEdges(graph_);
+		std::vector<bool> is_kept_edge(graph_.GetEdgeCount(), false);
+		for (const EdgeId edge_id : new_edge_ids)
+		{
+			if (edge_id != NO_EDGE)
+			{
+				is_kept_edge.at(edge_id) = true;
+			}
+		}
+		std::vector<EdgeId> added_edges;
+		for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+		{
+			if (!is_kept_edge[edge_id])
+			{
+				added_edges.push_back(edge_id);
+			}
+		}
+
+		// новая матрица: прежние строки с перенумерованными рёбрами и пустые столбцы новых вершин
+		RoutesInternalData data;
+		data.vertex_count = vertex_count;
+		if (routes_.sources)
+		{
+			data.sources.assign(routes_.sources, routes_.sources + routes_.rows_count);
+		}
+		const size_t rows_count = routes_.sources ? data.sources.size() : vertex_count;
+		const size_t old_rows_count = routes_.sources ? rows_count : old_vertex_count;
+		data.weights.assign(rows_count * vertex_count, ZERO_KEY);
+		data.prev_edges.assign(rows_count * vertex_count, NO_EDGE);
+
+		parallel::ThreadPool pool(threads_count);
+		SearchStatePool<Key> states_pool;
+		StatePool<std::vector<char>> statuses_pool;
+		std::atomic<size_t> repaired_rows_count = 0;
+		pool.ParallelFor(0, old_rows_count, ROWS_PER_TASK, [&](size_t rows_begin, size_t rows_end)
+		{
+			auto state = states_pool.Acquire();
+			auto statuses = statuses_pool.Acquire();
+			for (size_t row = rows_begin; row < rows_end; ++row)
+			{
+				const Key* old_weights = routes_.weights + row * old_vertex_count;
+				const uint32_t* old_prev_edges = routes_.prev_edges + row * old_vertex_count;
+				Key* weights = data.weights.data() + row * vertex_count;
+				uint32_t* prev_edges = data.prev_edges.data() + row * vertex_count;
+				const VertexId source = routes_.sources ? routes_.sources[row] : row;
+				for (VertexId vertex = 0; vertex < old_vertex_count; ++vertex)
+				{
+					weights[vertex] = old_weights[vertex];
+					if (old_prev_edges[vertex] != NO_EDGE)
+					{
+						prev_edges[vertex] = static_cast<uint32_t>(new_edge_ids.at(old_prev_edges[vertex]));
+					}
+				}
+				CutRemovedPaths(source, old_vertex_count, old_prev_edges, weights, prev_edges, *statuses);
+				if (RepairRow(source, old_vertex_count, added_edges, *statuses, weights, prev_edges, *state))
+				{
+					++repaired_rows_count;
+				}
+			}
+		});
+
+		// строки новых вершин полной матрицы считаются с нуля
+		std::vector<size_t> new_rows;
+		for (size_t row = old_rows_count; row < rows_count; ++row)
+		{
+			new_rows.push_back(row);
+		}
+		const bool has_sources = routes_.sources != nullptr;
+		routes_internal_data_ = std::move(data);
+		if (has_sources)
+		{
+			IndexSources(routes_internal_data_.sources.data(), routes_internal_data_.sources.size(), vertex_count);
+		}
+		ComputeRoutesByDijkstra(graph_, new_rows.size(), has_sources ? routes_internal_data_.sources.data() : nullptr,
+			threads_count, progress, new_rows.data());
+		UseOwnRoutesInternalData(has_sources);
+		// матрица теперь в собственной памяти, внешняя больше не нужна
+		storage_.reset();
+		return repaired_rows_count + new_rows.size();
 	}
 
 	template <typename Weight>
 	std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
 		VertexId to) const
 	{
-		const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-		if (!route_internal_data)
+		const size_t vertex_count = routes_.vertex_count;
+		if (from >= vertex_count || to >= vertex_count)
+		{
+			throw std::out_of_range("Vertex id is out of range");
+		}
+		if (!HasRow(from))
+		{
+			throw std::invalid_argument("Routes from the vertex are not precomputed");
+		}
+		const size_t row = GetRow(from);
+		if (!HasRoute(row, from, to))
 		{
 			return std::nullopt;
 		}
-		const Weight weight = route_internal_data->weight;
+		const size_t from_row = row * vertex_count;
+		const Weight weight = WeightTraits<Weight>::FromKey(routes_.weights[from_row + to]);
 		std::vector<EdgeId> edges;
-		for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-			edge_id;
-			edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+		for (uint32_t edge_id = routes_.prev_edges[from_row + to];
+			edge_id != NO_EDGE;
+			edge_id = routes_.prev_edges[from_row + graph_.GetEdgeSource(edge_id)])
 		{
-			edges.push_back(*edge_id);
+			edges.push_back(edge_id);
 		}
 		std::reverse(edges.begin(), edges.end());
 
 		return RouteInfo{ weight, std::move(edges) };
 	}
-} // namespace graph
\ No newline at end of file
+} // namespace graph
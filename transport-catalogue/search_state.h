@@ -0,0 +1,174 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace graph
+{
+	// состояние поиска кратчайших путей, переиспользуемое между запросами. Вершина считается
+	// достигнутой, только если её метка совпадает с номером текущего поиска, поэтому
+	// новый поиск не требует O(V) выделения и сброса массивов
+	template <typename Key>
+	class SearchState
+	{
+	public:
+		static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+		struct QueueItem
+		{
+			Key priority;
+			Key weight;
+			VertexId vertex;
+
+			// обратный порядок, чтобы на вершине кучи был минимальный приоритет
+			bool operator<(const QueueItem& other) const
+			{
+				return other.priority < priority;
+			}
+		};
+
+		// начинает новый поиск на графе из vertex_count вершин
+		void Reset(size_t vertex_count)
+		{
+			if (stamps_.size() < vertex_count)
+			{
+				stamps_.resize(vertex_count, 0);
+				weights_.resize(vertex_count);
+				prev_edges_.resize(vertex_count);
+			}
+			if (++stamp_ == 0)
+			{
+				std::fill(stamps_.begin(), stamps_.end(), 0);
+				stamp_ = 1;
+			}
+			queue_.clear();
+		}
+
+		bool IsReached(VertexId vertex) const
+		{
+			return stamps_[vertex] == stamp_;
+		}
+		const Key& GetWeight(VertexId vertex) const
+		{
+			return weights_[vertex];
+		}
+		EdgeId GetPrevEdge(VertexId vertex) const
+		{
+			return prev_edges_[vertex];
+		}
+		void Reach(VertexId vertex, const Key& weight, EdgeId prev_edge)
+		{
+			stamps_[vertex] = stamp_;
+			weights_[vertex] = weight;
+			prev_edges_[vertex] = prev_edge;
+		}
+
+		bool IsQueueEmpty() const
+		{
+			return queue_.empty();
+		}
+		const QueueItem& Top() const
+		{
+			return queue_.front();
+		}
+		void Push(const Key& priority, const Key& weight, VertexId vertex)
+		{
+			queue_.push_back({ priority, weight, vertex });
+			std::push_heap(queue_.begin(), queue_.end());
+		}
+		QueueItem Pop()
+		{
+			std::pop_heap(queue_.begin(), queue_.end());
+			QueueItem item = queue_.back();
+			queue_.pop_back();
+			return item;
+		}
+		void ClearQueue()
+		{
+			queue_.clear();
+		}
+
+	private:
+		std::vector<uint32_t> stamps_;
+		uint32_t stamp_ = 0;
+		std::vector<Key> weights_;
+		std::vector<EdgeId> prev_edges_;
+		std::vector<QueueItem> queue_;
+	};
+
+	// пул состояний поиска: параллельные запросы получают разные состояния,
+	// а последовательные переиспользуют уже выделенную память
+	template <typename State>
+	class StatePool
+	{
+	public:
+		// состояние, выданное запросу; по завершении возвращается в пул
+		class Lease
+		{
+		public:
+			Lease(StatePool& pool, std::unique_ptr<State> state)
+				: pool_(pool)
+				, state_(std::move(state))
+			{
+			}
+			~Lease()
+			{
+				pool_.Release(std::move(state_));
+			}
+
+			Lease(const Lease&) = delete;
+			Lease& operator=(const Lease&) = delete;
+
+			State& operator*() const
+			{
+				return *state_;
+			}
+			State* operator->() const
+			{
+				return state_.get();
+			}
+
+		private:
+			StatePool& pool_;
+			std::unique_ptr<State> state_;
+		};
+
+		Lease Acquire()
+		{
+			std::unique_ptr<State> state;
+			{
+				std::lock_guard lock(mutex_);
+				if (!free_states_.empty())
+				{
+					state = std::move(free_states_.back());
+					free_states_.pop_back();
+				}
+			}
+			if (!state)
+			{
+				state = std::make_unique<State>();
+			}
+			return Lease(*this, std::move(state));
+		}
+
+	private:
+		void Release(std::unique_ptr<State> state)
+		{
+			std::lock_guard lock(mutex_);
+			free_states_.push_back(std::move(state));
+		}
+
+		std::mutex mutex_;
+		std::vector<std::unique_ptr<State>> free_states_;
+	};
+
+	template <typename Key>
+	using SearchStatePool = StatePool<SearchState<Key>>;
+} // namespace graph
@@ -1,9 +1,37 @@
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 #include "serialization.h"
 
 namespace serialize
 {
+	namespace detail
+	{
+		constexpr char FILE_MAGIC[8] = { 'T', 'C', 'B', 'A', 'S', 'E', '0', '1' };
+		constexpr size_t SECTION_ALIGNMENT = 64;
+
+		struct FileHeader
+		{
+			char magic[8];
+			uint32_t sections_count;
+			uint32_t reserved;
+		};
+
+		struct SectionHeader
+		{
+			uint32_t id;
+			uint32_t reserved;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		size_t AlignOffset(size_t offset)
+		{
+			return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+		}
+	} // namespace detail
+
 	void Serializator::AddTransportCatalogue(const TransportCatalogue& catalogue)
 	{
 		SaveStops(catalogue);
@@ -18,106 +46,211 @@ namespace serialize
 
 	void Serializator::AddTransportRouter(const transport_catalogue::TransportRouter& router)
 	{
-		SaveTransportRouter(router);
 		SaveTransportRouterSettings(router.GetSettings());
 		SaveGraph(router.GetGraph());
 		SaveRouter(router.GetRouter());
+		SaveContractionHierarchy(router.GetContractionHierarchy());
+		SaveLandmarks(router.GetLandmarks());
+		SaveHubLabels(router.GetHubLabels());
 	}
 
 	bool Serializator::Serialize()
 	{
-		std::ofstream ofs(settings_.path, std::ios::binary);
-		if (!ofs.is_open())
+		// база пишется во временный файл и заменяет прежнюю целиком: прежний файл может быть
+		// отображён в память процессом, который её обновляет
+		std::filesystem::path temp_path = settings_.path;
+		temp_path += ".tmp";
+		std::ofstream ofs(temp_path, std::ios::binary);
+		std::string catalogue_data;
+		if (!ofs.is_open() || !proto_catalogue_.SerializeToString(&catalogue_data))
 		{
+			Clear();
 			return false;
 		}
-		proto_catalogue_.SerializeToOstream(&ofs);
+
+		std::vector<Section> sections{ { SectionId::CATALOGUE, catalogue_data.data(), catalogue_data.size() } };
+		sections.insert(sections.end(), sections_.begin(), sections_.end());
+
+		detail::FileHeader header{};
+		std::memcpy(header.magic, detail::FILE_MAGIC, sizeof(header.magic));
+		header.sections_count = static_cast<uint32_t>(sections.size());
+
+		std::vector<detail::SectionHeader> section_headers;
+		size_t offset = sizeof(detail::FileHeader) + sizeof(detail::SectionHeader) * sections.size();
+		for (const auto& section : sections)
+		{
+			offset = detail::AlignOffset(offset);
+			section_headers.push_back({ static_cast<uint32_t>(section.id), 0, offset, section.size });
+			offset += section.size;
+		}
+
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(section_headers.data()),
+			static_cast<std::streamsize>(sizeof(detail::SectionHeader) * section_headers.size()));
+		size_t written = sizeof(detail::FileHeader) + sizeof(detail::SectionHeader) * sections.size();
+		const char padding[detail::SECTION_ALIGNMENT] = {};
+		for (size_t i = 0; i < sections.size(); ++i)
+		{
+			ofs.write(padding, static_cast<std::streamsize>(section_headers[i].offset - written));
+			ofs.write(sections[i].data, static_cast<std::streamsize>(sections[i].size));
+			written = section_headers[i].offset + sections[i].size;
+		}
 		Clear();
-		return true;
+		ofs.close();
+		std::error_code error;
+		if (ofs.good())
+		{
+			std::filesystem::rename(temp_path, settings_.path, error);
+			if (!error)
+			{
+				return true;
+			}
+		}
+		std::filesystem::remove(temp_path, error);
+		return false;
 	}
 
 	bool Serializator::Deserialize(TransportCatalogue& catalogue,
 		std::optional<transport_catalogue::RenderSettings>& settings,
 		std::unique_ptr<TransportRouter>& router) {
-		std::ifstream ifs(settings_.path, std::ios::binary);
-		if (!ifs.is_open() || !proto_catalogue_.ParseFromIstream(&ifs))
+		mapped_file_ = std::make_shared<MappedFile>(settings_.path);
+		auto catalogue_data = mapped_file_->IsOpen() && ReadSections() ? FindSection(SectionId::CATALOGUE) : std::nullopt;
+		if (!catalogue_data || !proto_catalogue_.ParseFromArray(catalogue_data->data(), static_cast<int>(catalogue_data->size())))
 		{
+			Clear();
 			return false;
 		}
 
+		// расстояния загружаются раньше автобусов: задание расстояния помечает статистику
+		// проходящих через остановку автобусов устаревшей, а она уже есть в базе
 		LoadStops(catalogue);
-		LoadBuses(catalogue);
 		LoadDistances(catalogue);
+		LoadBuses(catalogue);
+		catalogue.Freeze();
 
 		LoadRenderSettings(settings);
 
-		LoadTransportRouter(catalogue, router);
+		const bool is_router_loaded = LoadTransportRouter(catalogue, router);
 
 		Clear();
-		return true;
+		return is_router_loaded;
 	}
 
 	void Serializator::Clear() noexcept
 	{
 		proto_catalogue_.Clear();
-		stop_name_by_id_.clear();
-		stop_id_by_name_.clear();
-		route_name_by_id_.clear();
-		route_id_by_name_.clear();
+		saved_bus_ids_.clear();
+		sections_.clear();
+		// отображение файла продолжают удерживать загруженные из него структуры
+		mapped_sections_.clear();
+		mapped_file_.reset();
+	}
+
+	void Serializator::AddSection(SectionId id, const void* data, size_t size)
+	{
+		sections_.push_back({ id, static_cast<const char*>(data), size });
+	}
+
+	bool Serializator::ReadSections()
+	{
+		const char* data = mapped_file_->GetData();
+		const size_t size = mapped_file_->GetSize();
+		detail::FileHeader header;
+		if (size < sizeof(header))
+		{
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (std::memcmp(header.magic, detail::FILE_MAGIC, sizeof(header.magic)) != 0
+			|| (size - sizeof(header)) / sizeof(detail::SectionHeader) < header.sections_count)
+		{
+			return false;
+		}
+		for (uint32_t i = 0; i < header.sections_count; ++i)
+		{
+			detail::SectionHeader section;
+			std::memcpy(&section, data + sizeof(header) + i * sizeof(section), sizeof(section));
+			if (section.offset > size || section.size > size - section.offset)
+			{
+				return false;
+			}
+			mapped_sections_[section.id] = std::string_view(data + section.offset, section.size);
+		}
+		return true;
+	}
+
+	std::optional<std::string_view> Serializator::FindSection(SectionId id) const
+	{
+		auto it = mapped_sections_.find(static_cast<uint32_t>(id));
+		if (it == mapped_sections_.end())
+		{
+			return std::nullopt;
+		}
+		return it->second;
 	}
 
 	void Serializator::SaveStops(const TransportCatalogue& catalogue)
 	{
-		auto& stops = catalogue.GetStopnameToStop();
-		uint32_t id = 0;
-		for (auto [name, stop] : stops)
+		// остановки пишутся по порядку номеров, и при загрузке получают те же номера
+		for (transport_catalogue::StopId id = 0; id < catalogue.GetStopCount(); ++id)
 		{
+			const transport_catalogue::Stop& stop = catalogue.GetStop(id);
 			transport_catalogue_serialize::Stop p_stop;
 			p_stop.set_id(id);
-			p_stop.set_name(stop->name);
-			*p_stop.mutable_coordinates() = MakeProtoCoordinates(stop->coordinates);
-			stop_id_by_name_.insert({ name, id++ });
+			p_stop.set_name(std::string(stop.name));
+			*p_stop.mutable_coordinates() = MakeProtoCoordinates(stop.coordinates);
 			*proto_catalogue_.mutable_catalogue()->add_stops() = std::move(p_stop);
 		}
 	}
 
 	void Serializator::SaveBuses(const TransportCatalogue& catalogue)
 	{
-		auto& buses = catalogue.GetBusnameToBus();
+		saved_bus_ids_.assign(catalogue.GetBusCount(), 0);
 		uint32_t id = 0;
-		for (auto [name, bus] : buses)
+		for (transport_catalogue::BusId bus_id = 0; bus_id < catalogue.GetBusCount(); ++bus_id)
 		{
+			if (catalogue.IsBusRemoved(bus_id))
+			{
+				continue;
+			}
+			const transport_catalogue::Bus& bus = catalogue.GetBus(bus_id);
 			transport_catalogue_serialize::Bus p_bus;
 			p_bus.set_id(id);
-			p_bus.set_name(bus->name);
-			p_bus.set_is_roundtrip(bus->is_roundtrip);
-			SaveBusesStops(*bus, p_bus);
-			route_id_by_name_.insert({ name, id++ });
-			*proto_catalogue_.mutable_catalogue()->add_routes() = std::move(p_bus);
+			p_bus.set_name(std::string(bus.name));
+			p_bus.set_is_roundtrip(bus.is_roundtrip);
+			SaveBusesStops(catalogue, bus, p_bus);
+			const transport_catalogue::BusInfo* bus_info = catalogue.GetBusInfo(bus.name);
+			auto p_info = p_bus.mutable_info();
+			p_info->set_stop_count(bus_info->amount_stops);
+			p_info->set_unique_stop_count(bus_info->uniq_stops);
+			p_info->set_route_length(bus_info->route_length);
+			p_info->set_curvature(bus_info->curvature);
+			saved_bus_ids_[bus_id] = id++;
+			*proto_catalogue_.mutable_catalogue()->add_buses() = std::move(p_bus);
 		}
 	}
 
-	void Serializator::SaveBusesStops(const transport_catalogue::Bus& bus,
+	void Serializator::SaveBusesStops(const TransportCatalogue& catalogue, const transport_catalogue::Bus& bus,
 		transport_catalogue_serialize::Bus& p_bus)
 	{
-		for (auto stop : bus.stops)
+		for (const transport_catalogue::StopId stop_id : catalogue.GetBusStops(bus.id))
 		{
-			p_bus.add_stop_ids(stop_id_by_name_.at(stop->name));
+			p_bus.add_stop_ids(stop_id);
 		}
 	}
 
 	void Serializator::SaveDistances(const TransportCatalogue& catalogue)
 	{
-		auto& distances = catalogue.GetDistances();
-		for (const auto& [stopsPair, distance] : distances)
+		for (transport_catalogue::StopId stop_from = 0; stop_from < catalogue.GetStopCount(); ++stop_from)
 		{
-			const auto& stop1 = stopsPair.first;
-			const auto& stop2 = stopsPair.second;
-			transport_catalogue_serialize::Distance p_distance;
-			p_distance.set_stop_id_from(stop_id_by_name_.at(stop1->name));
-			p_distance.set_stop_id_to(stop_id_by_name_.at(stop2->name));
-			p_distance.set_distance(distance);
-			*proto_catalogue_.mutable_catalogue()->add_distances() = std::move(p_distance);
+			for (const auto& [stop_to, distance] : catalogue.GetDistancesFrom(stop_from))
+			{
+				transport_catalogue_serialize::Distance p_distance;
+				p_distance.set_stop_id_from(stop_from);
+				p_distance.set_stop_id_to(stop_to);
+				p_distance.set_distance(distance);
+				*proto_catalogue_.mutable_catalogue()->add_distances() = std::move(p_distance);
+			}
 		}
 	}
 
@@ -147,75 +280,129 @@ namespace serialize
 		}
 	}
 
-	void Serializator::SaveTransportRouter(const TransportRouter& router)
-	{
-		auto p_stops_by_id = proto_catalogue_.mutable_router()->mutable_stop_by_id();
-		for (auto [name, id] : router.GetIdsByStopName())
-		{
-			transport_router_serialize::StopById stop_by_id;
-			stop_by_id.set_id(id);
-			stop_by_id.set_stop_id(stop_id_by_name_.at(name));
-			*p_stops_by_id->Add() = std::move(stop_by_id);
-		}
-	}
-
 	void Serializator::SaveTransportRouterSettings(const transport_catalogue::RoutingSettings& routing_settings)
 	{
 		auto p_settings = proto_catalogue_.mutable_router()->mutable_settings();
 
 		p_settings->set_wait_time(routing_settings.wait_time);
 		p_settings->set_velocity(routing_settings.velocity);
+		p_settings->set_router_type(static_cast<transport_router_serialize::RouterType>(routing_settings.router_type));
+		p_settings->set_graph_model(static_cast<transport_router_serialize::GraphModel>(routing_settings.graph_model));
+		p_settings->set_landmarks_count(routing_settings.landmarks_count);
+		p_settings->set_route_cache_capacity(routing_settings.route_cache_capacity);
+		p_settings->set_hub_labels(routing_settings.hub_labels);
+		p_settings->set_all_pairs_method(static_cast<transport_router_serialize::PrecomputeMethod>(routing_settings.all_pairs_method));
+		for (const std::string& stop_name : routing_settings.hot_stops)
+		{
+			p_settings->add_hot_stops(stop_name);
+		}
 	}
 
 	void Serializator::SaveGraph(const TransportRouter::Graph& graph)
 	{
 		auto p_graph = proto_catalogue_.mutable_router()->mutable_graph();
 
-		for (auto& edge : graph.GetEdges())
+		for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id)
 		{
 			graph_serialize::Edge p_edge;
-			p_edge.set_from(edge.from);
-			p_edge.set_to(edge.to);
-			*p_edge.mutable_weight() = MakeProtoWeight(edge.weight);
+			p_edge.set_to(graph.GetEdgeTarget(edge_id));
+			*p_edge.mutable_weight() = MakeProtoWeight(graph.GetEdgeWeight(edge_id));
 			*p_graph->add_edges() = std::move(p_edge);
 		}
 
-		for (auto& list : graph.GetIncidenceLists())
+		for (const auto offset : graph.GetOffsets())
 		{
-			auto p_list = p_graph->add_incidence_lists();
-			for (auto id : list)
-			{
-				p_list->add_edge_id(id);
-			}
+			p_graph->add_offsets(offset);
 		}
 	}
 
 	void Serializator::SaveRouter(const std::unique_ptr<TransportRouter::Router>& router)
 	{
+		// маршрутизатор без предрасчёта нечего сохранять
+		if (!router)
+		{
+			return;
+		}
 		auto p_router = proto_catalogue_.mutable_router()->mutable_router();
+		const auto& routes = router->GetRoutes();
+		const size_t cells_count = routes.rows_count * routes.vertex_count;
 
-		for (const auto& data : router->GetRoutesInternalData())
-		{
-			graph_serialize::RoutesInternalData p_data;
-		for (const auto& internal: data)
+		p_router->set_vertex_count(routes.vertex_count);
+		if (routes.sources)
 		{
-			graph_serialize::OptionalRouteInternalData p_internal;
-			if (internal.has_value())
+			p_router->set_partial(true);
+			for (size_t row = 0; row < routes.rows_count; ++row)
 			{
-				auto& value = internal.value();
-				auto p_value = p_internal.mutable_route_internal_data();
-				p_value->set_total_time(value.weight.total_time);
-				if (value.prev_edge.has_value())
-				{
-					p_value->set_prev_edge(value.prev_edge.value());
-				}
+				p_router->add_sources(routes.sources[row]);
 			}
-			*p_data.add_routes_internal_data() = std::move(p_internal);
 		}
-								 *p_router->add_routes_internal_data() = std::move(p_data);
+		AddSection(SectionId::ROUTE_WEIGHTS, routes.weights, cells_count * sizeof(*routes.weights));
+		AddSection(SectionId::ROUTE_PREV_EDGES, routes.prev_edges, cells_count * sizeof(*routes.prev_edges));
+	}
+
+	void Serializator::SaveContractionHierarchy(const std::unique_ptr<TransportRouter::ContractionHierarchy>& hierarchy)
+	{
+		if (!hierarchy)
+		{
+			return;
+		}
+		auto p_hierarchy = proto_catalogue_.mutable_router()->mutable_contraction_hierarchy();
+
+		for (auto rank : hierarchy->GetRanks())
+		{
+			p_hierarchy->add_ranks(rank);
+		}
+		for (const auto& shortcut : hierarchy->GetShortcuts())
+		{
+			auto p_shortcut = p_hierarchy->add_shortcuts();
+			p_shortcut->set_from(shortcut.edge.from);
+			p_shortcut->set_to(shortcut.edge.to);
+			p_shortcut->set_total_time(shortcut.edge.weight);
+			p_shortcut->set_first_edge(shortcut.first_edge);
+			p_shortcut->set_second_edge(shortcut.second_edge);
 		}
 	}
 
+	void Serializator::SaveLandmarks(const std::unique_ptr<TransportRouter::Landmarks>& landmarks)
+	{
+		if (!landmarks)
+		{
+			return;
+		}
+		auto p_landmarks = proto_catalogue_.mutable_router()->mutable_landmarks();
+		const auto& tables = landmarks->GetTables();
+		for (auto vertex : tables.landmarks)
+		{
+			p_landmarks->add_vertices(vertex);
+		}
+
+		const size_t cells_count = tables.vertex_count * tables.landmarks.size();
+		AddSection(SectionId::LANDMARK_DISTANCES_FROM, tables.distances_from, cells_count * sizeof(*tables.distances_from));
+		AddSection(SectionId::LANDMARK_DISTANCES_TO, tables.distances_to, cells_count * sizeof(*tables.distances_to));
+	}
+
+	void Serializator::SaveHubLabels(const std::unique_ptr<TransportRouter::HubLabels>& hub_labels)
+	{
+		if (!hub_labels)
+		{
+			return;
+		}
+		proto_catalogue_.mutable_router()->mutable_hub_labels()->set_vertex_count(hub_labels->GetOutLabels().vertex_count);
+		AddLabelsSections(hub_labels->GetOutLabels(),
+			SectionId::HUB_LABELS_OUT_OFFSETS, SectionId::HUB_LABELS_OUT_HUBS, SectionId::HUB_LABELS_OUT_WEIGHTS);
+		AddLabelsSections(hub_labels->GetInLabels(),
+			SectionId::HUB_LABELS_IN_OFFSETS, SectionId::HUB_LABELS_IN_HUBS, SectionId::HUB_LABELS_IN_WEIGHTS);
+	}
+
+	void Serializator::AddLabelsSections(const TransportRouter::HubLabels::LabelsView& labels, SectionId offsets_id,
+		SectionId hubs_id, SectionId weights_id)
+	{
+		const size_t entries_count = labels.offsets[labels.vertex_count];
+		AddSection(offsets_id, labels.offsets, (labels.vertex_count + 1) * sizeof(*labels.offsets));
+		AddSection(hubs_id, labels.hubs, entries_count * sizeof(*labels.hubs));
+		AddSection(weights_id, labels.weights, entries_count * sizeof(*labels.weights));
+	}
+
 	void Serializator::LoadStops(TransportCatalogue& catalogue)
 	{
 		auto stops_count = proto_catalogue_.catalogue().stops_size();
@@ -226,32 +413,38 @@ namespace serialize
 			stop.name = p_stop.name();
 			stop.coordinates = MakeCoordinates(p_stop.coordinates());
 			catalogue.AddStop(stop);
-			stop_name_by_id_.insert({ p_stop.id(), p_stop.name() });
 		}
 	}
 
 	void Serializator::LoadBuses(TransportCatalogue& catalogue)
 	{
-		auto routes_count = proto_catalogue_.catalogue().routes_size();
+		auto routes_count = proto_catalogue_.catalogue().buses_size();
 		for (int i = 0; i < routes_count; ++i)
 		{
 			auto& p_bus = proto_catalogue_.catalogue().buses(i);
 			LoadBus(catalogue, p_bus);
-			route_name_by_id_.insert({ p_bus.id(), p_bus.name() });
 		}
 	}
 
 	void Serializator::LoadBus(TransportCatalogue& catalogue, const transport_catalogue_serialize::Bus& p_bus) const
 	{
 		auto stops_count = p_bus.stop_ids_size();
-		std::vector<std::string> stops;
+		std::vector<transport_catalogue::StopId> stops;
 		stops.reserve(stops_count);
 		for (int i = 0; i < stops_count; ++i)
 		{
-			auto stop_name = stop_name_by_id_.at(p_bus.stop_ids(i));
-			stops.push_back(std::string(stop_name));
+			stops.push_back(p_bus.stop_ids(i));
 		}
 		catalogue.AddBus(p_bus.name(), p_bus.is_roundtrip(), stops);
+		if (p_bus.has_info())
+		{
+			transport_catalogue::BusInfo bus_info;
+			bus_info.amount_stops = p_bus.info().stop_count();
+			bus_info.uniq_stops = p_bus.info().unique_stop_count();
+			bus_info.route_length = p_bus.info().route_length();
+			bus_info.curvature = p_bus.info().curvature();
+			catalogue.SetBusInfo(catalogue.FindBus(p_bus.name())->id, bus_info);
+		}
 	}
 
 	void Serializator::LoadDistances(TransportCatalogue& catalogue) const
@@ -260,9 +453,7 @@ namespace serialize
 		for (int i = 0; i < distances_count; ++i)
 		{
 			auto& p_distance = proto_catalogue_.catalogue().distances(i);
-			auto stop_from = std::string(stop_name_by_id_.at(p_distance.stop_id_from()));
-			auto stop_to = std::string(stop_name_by_id_.at(p_distance.stop_id_to()));
-			catalogue.SetDistance(stop_from, stop_to, p_distance.distance());
+			catalogue.SetDistance(p_distance.stop_id_from(), p_distance.stop_id_to(), p_distance.distance());
 		}
 	}
 
@@ -302,11 +493,11 @@ namespace serialize
 		result_settings = settings;
 	}
 
-	void Serializator::LoadTransportRouter(const TransportCatalogue& catalogue, std::unique_ptr<TransportRouter>& transport_router)
+	bool Serializator::LoadTransportRouter(const TransportCatalogue& catalogue, std::unique_ptr<TransportRouter>& transport_router)
 	{
 		if (!proto_catalogue_.has_router())
 		{
-			return;
+			return true;
 		}
 		transport_catalogue::RoutingSettings routing_settings;
 		LoadTransportRouterSettings(routing_settings);
@@ -314,22 +505,31 @@ namespace serialize
 		transport_router = std::make_unique<TransportRouter>(catalogue, routing_settings);
 
 		auto& p_router = proto_catalogue_.router();
-		auto stops_count = p_router.stop_by_id_size();
-		for (auto i = 0; i < stops_count; ++i)
+		if (!LoadGraph(catalogue, transport_router->GetGraph()))
 		{
-			auto& p_stop_by_id = p_router.stop_by_id(i);
-			auto stop = catalogue.GetStopnameToStop().at(stop_name_by_id_.at(p_stop_by_id.stop_id()));
-			transport_router->GetStopsById().insert({ p_stop_by_id.id(), stop });
-			transport_router->GetIdsByStopName().insert({ stop->name, p_stop_by_id.id() });
+			return false;
 		}
 
-		LoadGraph(catalogue, transport_router->GetGraph());
-
-		transport_router->GetRouter() =
-			std::make_unique<TransportRouter::Router>(transport_router->GetGraph(), false);
-		LoadRouter(catalogue, transport_router->GetRouter());
+		if (p_router.has_router() && !LoadRouter(transport_router->GetGraph(), transport_router->GetRouter()))
+		{
+			return false;
+		}
+		if (p_router.has_contraction_hierarchy()
+			&& !LoadContractionHierarchy(transport_router->GetGraph(), transport_router->GetContractionHierarchy()))
+		{
+			return false;
+		}
+		if (p_router.has_landmarks() && !LoadLandmarks(transport_router->GetGraph(), transport_router->GetLandmarks()))
+		{
+			return false;
+		}
+		if (p_router.has_hub_labels() && !LoadHubLabels(transport_router->GetGraph(), transport_router->GetHubLabels()))
+		{
+			return false;
+		}
 
 		transport_router->InternalInit();
+		return true;
 	}
 
 	void Serializator::LoadTransportRouterSettings(transport_catalogue::RoutingSettings& routing_settings) const
@@ -338,75 +538,202 @@ namespace serialize
 
 		routing_settings.wait_time = p_settings.wait_time();
 		routing_settings.velocity = p_settings.velocity();
+		routing_settings.router_type = static_cast<transport_catalogue::RouterType>(p_settings.router_type());
+		routing_settings.graph_model = static_cast<transport_catalogue::GraphModel>(p_settings.graph_model());
+		routing_settings.landmarks_count = p_settings.landmarks_count();
+		routing_settings.route_cache_capacity = p_settings.route_cache_capacity();
+		routing_settings.hub_labels = p_settings.hub_labels();
+		routing_settings.all_pairs_method = static_cast<graph::PrecomputeMethod>(p_settings.all_pairs_method());
+		routing_settings.hot_stops.assign(p_settings.hot_stops().begin(), p_settings.hot_stops().end());
 	}
 
-	void Serializator::LoadGraph(const TransportCatalogue& catalogue, TransportRouter::Graph& graph)
+	bool Serializator::LoadGraph(const TransportCatalogue& catalogue, TransportRouter::Graph& graph)
 	{
 		auto& p_graph = proto_catalogue_.router().graph();
-		auto edge_count = p_graph.edges_size();
-
-		for (auto i = 0; i < edge_count; ++i)
+		const size_t edge_count = static_cast<size_t>(p_graph.edges_size());
+		std::vector<graph::EdgeId> offsets(p_graph.offsets().begin(), p_graph.offsets().end());
+		if (offsets.empty() || offsets.front() != 0 || offsets.back() != edge_count
+			|| !std::is_sorted(offsets.begin(), offsets.end()))
 		{
-			graph::Edge<transport_catalogue::RouteWeight> edge;
-			auto& p_edge = p_graph.edges(i);
-			edge.from = p_edge.from();
-			edge.to = p_edge.to();
-			edge.weight = MakeWeight(catalogue, p_edge.weight());
-			graph.GetEdges().push_back(std::move(edge));
+			return false;
 		}
 
-		auto incidence_lists_count = p_graph.incidence_lists_size();
-		for (auto i = 0; i < incidence_lists_count; ++i)
+		std::vector<uint32_t> targets;
+		std::vector<transport_catalogue::RouteWeight> weights;
+		targets.reserve(edge_count);
+		weights.reserve(edge_count);
+		for (const auto& p_edge : p_graph.edges())
 		{
-			TransportRouter::Graph::IncidenceList list;
-			auto& p_list = p_graph.incidence_lists(i);
-			auto list_count = p_list.edge_id_size();
-			for (auto j = 0; j < list_count; ++j)
+			if (p_edge.to() >= offsets.size() - 1)
 			{
-				list.push_back(p_list.edge_id(j));
+				return false;
 			}
-			graph.GetIncidenceLists().push_back(list);
+			targets.push_back(p_edge.to());
+			weights.push_back(MakeWeight(catalogue, p_edge.weight()));
 		}
+		graph = TransportRouter::Graph(std::move(offsets), std::move(targets), std::move(weights));
+		return true;
 	}
 
-	void Serializator::LoadRouter(const TransportCatalogue& catalogue,
-		std::unique_ptr<TransportRouter::Router>& router)
+	bool Serializator::LoadRouter(const TransportRouter::Graph& graph, std::unique_ptr<TransportRouter::Router>& router)
 	{
+		using RoutesView = TransportRouter::Router::RoutesView;
 		auto& p_router = proto_catalogue_.router().router();
-		auto& routes_internal_data = router->GetRoutesInternalData();
+		const size_t rows_count = p_router.partial() ? p_router.sources_size() : p_router.vertex_count();
+		const size_t cells_count = rows_count * p_router.vertex_count();
+
+		auto weights = FindSection(SectionId::ROUTE_WEIGHTS);
+		auto prev_edges = FindSection(SectionId::ROUTE_PREV_EDGES);
+		RoutesView routes;
+		if (!weights || !prev_edges || p_router.vertex_count() != graph.GetVertexCount()
+			|| weights->size() != cells_count * sizeof(*routes.weights)
+			|| prev_edges->size() != cells_count * sizeof(*routes.prev_edges))
+		{
+			return false;
+		}
+
+		// матрица используется прямо из отображённого файла, без разбора и копирования
+		routes.vertex_count = p_router.vertex_count();
+		routes.weights = reinterpret_cast<decltype(routes.weights)>(weights->data());
+		routes.prev_edges = reinterpret_cast<decltype(routes.prev_edges)>(prev_edges->data());
+		routes.rows_count = rows_count;
+		if (p_router.partial())
+		{
+			routes.sources = p_router.sources().data();
+			if (std::any_of(p_router.sources().begin(), p_router.sources().end(), [&graph](uint32_t source)
+			{
+				return source >= graph.GetVertexCount();
+			}))
+			{
+				return false;
+			}
+		}
+		router = std::make_unique<TransportRouter::Router>(graph, routes, mapped_file_);
+		return true;
+	}
 
-		auto routes_internal_data_count = p_router.routes_internal_data_size();
+	bool Serializator::LoadContractionHierarchy(const TransportRouter::Graph& graph,
+		std::unique_ptr<TransportRouter::ContractionHierarchy>& hierarchy) const
+	{
+		auto& p_hierarchy = proto_catalogue_.router().contraction_hierarchy();
+		const size_t vertex_count = graph.GetVertexCount();
 
-		for (int i = 0; i < routes_internal_data_count; ++i)
+		// ранги - перестановка номеров вершин: при равных рангах поиск теряет рёбра между ними
+		std::vector<size_t> ranks(p_hierarchy.ranks().begin(), p_hierarchy.ranks().end());
+		if (ranks.size() != vertex_count)
+		{
+			return false;
+		}
+		std::vector<bool> is_rank_used(vertex_count, false);
+		for (const size_t rank : ranks)
 		{
-			auto& p_internal_data = p_router.routes_internal_data(i);
-			auto internal_data_count = p_internal_data.routes_internal_data_size();
-			for (int j = 0; j < internal_data_count; ++j)
+			if (rank >= vertex_count || is_rank_used[rank])
 			{
-				auto& p_optional_data = p_internal_data.routes_internal_data(j);
-				if (p_optional_data.optional_route_internal_data_case() ==
-					graph_serialize::OptionalRouteInternalData::kRouteInternalData)
-				{
-					TransportRouter::Router::RouteInternalData data;
-					auto& p_data = p_optional_data.route_internal_data();
-					data.weight.total_time = p_data.total_time();
-					if (p_data.optional_prev_edge_case() ==
-						graph_serialize::RouteInternalData::kPrevEdge)
-					{
-						data.prev_edge = p_data.prev_edge();
-					}
-					else
-					{
-						data.prev_edge = std::nullopt;
-					}
-					routes_internal_data[i][j] = std::move(data);
-				}
-				else
-				{
-					routes_internal_data[i][j] = std::nullopt;
-				}
+				return false;
 			}
+			is_rank_used[rank] = true;
+		}
+
+		std::vector<TransportRouter::ContractionHierarchy::Shortcut> shortcuts;
+		shortcuts.reserve(p_hierarchy.shortcuts_size());
+		for (const auto& p_shortcut : p_hierarchy.shortcuts())
+		{
+			// шорткат заменяет рёбра графа или более ранние шорткаты, иначе его не развернуть
+			const size_t edges_before = graph.GetEdgeCount() + shortcuts.size();
+			if (p_shortcut.from() >= vertex_count || p_shortcut.to() >= vertex_count
+				|| p_shortcut.first_edge() >= edges_before || p_shortcut.second_edge() >= edges_before)
+			{
+				return false;
+			}
+			TransportRouter::ContractionHierarchy::Shortcut shortcut;
+			shortcut.edge.from = p_shortcut.from();
+			shortcut.edge.to = p_shortcut.to();
+			shortcut.edge.weight = p_shortcut.total_time();
+			shortcut.first_edge = p_shortcut.first_edge();
+			shortcut.second_edge = p_shortcut.second_edge();
+			shortcuts.push_back(std::move(shortcut));
+		}
+
+		hierarchy = std::make_unique<TransportRouter::ContractionHierarchy>(graph, std::move(ranks), std::move(shortcuts));
+		return true;
+	}
+
+	bool Serializator::LoadLandmarks(const TransportRouter::Graph& graph, std::unique_ptr<TransportRouter::Landmarks>& landmarks)
+	{
+		using TablesView = TransportRouter::Landmarks::TablesView;
+		auto& p_landmarks = proto_catalogue_.router().landmarks();
+
+		TablesView tables;
+		tables.vertex_count = graph.GetVertexCount();
+		tables.landmarks.assign(p_landmarks.vertices().begin(), p_landmarks.vertices().end());
+		const size_t cells_count = tables.vertex_count * tables.landmarks.size();
+
+		auto distances_from = FindSection(SectionId::LANDMARK_DISTANCES_FROM);
+		auto distances_to = FindSection(SectionId::LANDMARK_DISTANCES_TO);
+		if (!distances_from || !distances_to
+			|| distances_from->size() != cells_count * sizeof(*tables.distances_from)
+			|| distances_to->size() != cells_count * sizeof(*tables.distances_to))
+		{
+			return false;
+		}
+		for (auto vertex : tables.landmarks)
+		{
+			if (vertex >= tables.vertex_count)
+			{
+				return false;
+			}
+		}
+
+		tables.distances_from = reinterpret_cast<decltype(tables.distances_from)>(distances_from->data());
+		tables.distances_to = reinterpret_cast<decltype(tables.distances_to)>(distances_to->data());
+		landmarks = std::make_unique<TransportRouter::Landmarks>(graph, std::move(tables), mapped_file_);
+		return true;
+	}
+
+	bool Serializator::LoadHubLabels(const TransportRouter::Graph& graph, std::unique_ptr<TransportRouter::HubLabels>& hub_labels)
+	{
+		const size_t vertex_count = proto_catalogue_.router().hub_labels().vertex_count();
+		if (vertex_count != graph.GetVertexCount())
+		{
+			return false;
+		}
+		auto out_labels = FindLabelsSections(vertex_count,
+			SectionId::HUB_LABELS_OUT_OFFSETS, SectionId::HUB_LABELS_OUT_HUBS, SectionId::HUB_LABELS_OUT_WEIGHTS);
+		auto in_labels = FindLabelsSections(vertex_count,
+			SectionId::HUB_LABELS_IN_OFFSETS, SectionId::HUB_LABELS_IN_HUBS, SectionId::HUB_LABELS_IN_WEIGHTS);
+		if (!out_labels || !in_labels)
+		{
+			return false;
+		}
+		hub_labels = std::make_unique<TransportRouter::HubLabels>(graph, *out_labels, *in_labels, mapped_file_);
+		return true;
+	}
+
+	std::optional<transport_catalogue::TransportRouter::HubLabels::LabelsView> Serializator::FindLabelsSections(size_t vertex_count,
+		SectionId offsets_id, SectionId hubs_id, SectionId weights_id) const
+	{
+		TransportRouter::HubLabels::LabelsView labels;
+		auto offsets = FindSection(offsets_id);
+		auto hubs = FindSection(hubs_id);
+		auto weights = FindSection(weights_id);
+		if (!offsets || !hubs || !weights || offsets->size() != (vertex_count + 1) * sizeof(*labels.offsets))
+		{
+			return std::nullopt;
+		}
+		labels.vertex_count = vertex_count;
+		labels.offsets = reinterpret_cast<decltype(labels.offsets)>(offsets->data());
+		labels.hubs = reinterpret_cast<decltype(labels.hubs)>(hubs->data());
+		labels.weights = reinterpret_cast<decltype(labels.weights)>(weights->data());
+
+		// смещения должны расти и указывать внутрь массивов хабов и весов
+		const uint64_t entries_count = labels.offsets[vertex_count];
+		if (labels.offsets[0] != 0 || hubs->size() != entries_count * sizeof(*labels.hubs)
+			|| weights->size() != entries_count * sizeof(*labels.weights)
+			|| !std::is_sorted(labels.offsets, labels.offsets + vertex_count + 1))
+		{
+			return std::nullopt;
 		}
+		return labels;
 	}
 
 	transport_catalogue_serialize::Coordinates Serializator::MakeProtoCoordinates(const geo::Coordinates& coordinates)
@@ -498,7 +825,7 @@ namespace serialize
 	graph_serialize::RouteWeight Serializator::MakeProtoWeight(const transport_catalogue::RouteWeight& weight) const
 	{
 		graph_serialize::RouteWeight p_weight;
-		p_weight.set_bus_id(route_id_by_name_.at(weight.bus_name));
+		p_weight.set_bus_id(saved_bus_ids_.at(weight.bus_id));
 		p_weight.set_span_count(weight.span_count);
 		p_weight.set_total_time(weight.total_time);
 		return p_weight;
@@ -508,8 +835,8 @@ namespace serialize
 	{
 		transport_catalogue::RouteWeight weight;
 
-		auto route_name = catalogue.GetBusnameToBus().at(route_name_by_id_.at(p_weight.bus_id()));
-		weight.bus_name = route_name->name;
+		// номера автобусов в базе совпадают с номерами загруженного из неё справочника
+		weight.bus_id = catalogue.GetBus(p_weight.bus_id()).id;
 		weight.span_count = p_weight.span_count();
 		weight.total_time = p_weight.total_time();
 		return weight;
@@ -1,16 +1,40 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "map_renderer.h"
+#include "mapped_file.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 #include "transport_catalogue.pb.h"
 
 namespace serialize 
 {
+	// Файл базы состоит из заголовка с таблицей секций и самих секций, каждая выровнена
+	// по SECTION_ALIGNMENT. Секция CATALOGUE хранит protobuf-сообщение, остальные - плоские
+	// массивы, которые process_requests использует прямо из отображённого в память файла
+	enum class SectionId : uint32_t
+	{
+		CATALOGUE = 0,
+		ROUTE_WEIGHTS = 1,
+		ROUTE_PREV_EDGES = 2,
+		LANDMARK_DISTANCES_FROM = 3,
+		LANDMARK_DISTANCES_TO = 4,
+		HUB_LABELS_OUT_OFFSETS = 5,
+		HUB_LABELS_OUT_HUBS = 6,
+		HUB_LABELS_OUT_WEIGHTS = 7,
+		HUB_LABELS_IN_OFFSETS = 8,
+		HUB_LABELS_IN_HUBS = 9,
+		HUB_LABELS_IN_WEIGHTS = 10,
+	};
+
 	class Serializator final 
 	{
 	public:
@@ -38,15 +62,28 @@ namespace serialize
 			std::unique_ptr<TransportRouter>& router_);
 
 	private:
+		struct Section
+		{
+			SectionId id;
+			const char* data;
+			size_t size;
+		};
+
 		void Clear() noexcept;
 
+		// данные секции должны оставаться доступными до вызова Serialize
+		void AddSection(SectionId id, const void* data, size_t size);
+		bool ReadSections();
+		std::optional<std::string_view> FindSection(SectionId id) const;
+
 		void SaveStops(const TransportCatalogue& catalogue);
 		void LoadStops(TransportCatalogue& catalogue);
 
 		void SaveBuses(const TransportCatalogue& catalogue);
 		void LoadBuses(TransportCatalogue& catalogue);
 
-		void SaveBusesStops(const transport_catalogue::Bus& bus, transport_catalogue_serialize::Bus& p_bus);
+		void SaveBusesStops(const TransportCatalogue& catalogue, const transport_catalogue::Bus& bus,
+			transport_catalogue_serialize::Bus& p_bus);
 		void LoadBus(TransportCatalogue& catalogue, const transport_catalogue_serialize::Bus& p_bus) const;
 
 		void SaveDistances(const TransportCatalogue& catalogue);
@@ -55,18 +92,31 @@ namespace serialize
 		void SaveRenderSettings(const transport_catalogue::RenderSettings& settings);
 		void LoadRenderSettings(std::optional<transport_catalogue::RenderSettings>& settings) const;
 
-		void SaveTransportRouter(const TransportRouter& router);
-		void LoadTransportRouter(const TransportCatalogue& catalogue,
+		bool LoadTransportRouter(const TransportCatalogue& catalogue,
 			std::unique_ptr<TransportRouter>& transport_router);
 
 		void SaveTransportRouterSettings(const transport_catalogue::RoutingSettings& routing_settings);
 		void LoadTransportRouterSettings(transport_catalogue::RoutingSettings& routing_settings) const;
 
 		void SaveGraph(const TransportRouter::Graph& graph);
-		void LoadGraph(const TransportCatalogue& catalogue, TransportRouter::Graph& graph);
+		bool LoadGraph(const TransportCatalogue& catalogue, TransportRouter::Graph& graph);
 
 		void SaveRouter(const std::unique_ptr<TransportRouter::Router>& router);
-		void LoadRouter(const TransportCatalogue& catalogue, std::unique_ptr<TransportRouter::Router>& router);
+		bool LoadRouter(const TransportRouter::Graph& graph, std::unique_ptr<TransportRouter::Router>& router);
+
+		void SaveContractionHierarchy(const std::unique_ptr<TransportRouter::ContractionHierarchy>& hierarchy);
+		bool LoadContractionHierarchy(const TransportRouter::Graph& graph,
+			std::unique_ptr<TransportRouter::ContractionHierarchy>& hierarchy) const;
+
+		void SaveLandmarks(const std::unique_ptr<TransportRouter::Landmarks>& landmarks);
+		bool LoadLandmarks(const TransportRouter::Graph& graph, std::unique_ptr<TransportRouter::Landmarks>& landmarks);
+
+		void SaveHubLabels(const std::unique_ptr<TransportRouter::HubLabels>& hub_labels);
+		bool LoadHubLabels(const TransportRouter::Graph& graph, std::unique_ptr<TransportRouter::HubLabels>& hub_labels);
+		void AddLabelsSections(const TransportRouter::HubLabels::LabelsView& labels, SectionId offsets_id, SectionId hubs_id,
+			SectionId weights_id);
+		std::optional<TransportRouter::HubLabels::LabelsView> FindLabelsSections(size_t vertex_count, SectionId offsets_id,
+			SectionId hubs_id, SectionId weights_id) const;
 
 		static transport_catalogue_serialize::Coordinates MakeProtoCoordinates(const geo::Coordinates& coordinates);
 		static geo::Coordinates MakeCoordinates(const transport_catalogue_serialize::Coordinates& p_coordinates);
@@ -84,9 +134,11 @@ namespace serialize
 		Settings settings_;
 
 		ProtoTransportCatalogue proto_catalogue_;
-		std::unordered_map<int, std::string_view> stop_name_by_id_;
-		std::unordered_map<std::string_view, int> stop_id_by_name_;
-		std::unordered_map<int, std::string_view> route_name_by_id_;
-		std::unordered_map<std::string_view, int> route_id_by_name_;
+		// номера автобусов в базе по номерам справочника: удалённые автобусы в базу не попадают
+		std::vector<uint32_t> saved_bus_ids_;
+
+		std::vector<Section> sections_;
+		std::shared_ptr<const MappedFile> mapped_file_;
+		std::unordered_map<uint32_t, std::string_view> mapped_sections_;
 	};
 } // namespace serialize
@@ -1,121 +1,247 @@
 #include "transport_catalogue.h"
 #include "geo.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
 
 using namespace std::literals;
 
 namespace transport_catalogue
 {
-	namespace detail
+	void TransportCatalogue::AddStop(Stop stop)
+	{
+		stop.id = static_cast<StopId>(stops_.size());
+		stop.name = pending_names_.emplace_back(stop.name);
+		stops_.push_back(stop);
+		Stop* stop_ptr = &stops_.back();
+		stopname_to_stop_.emplace(stop_ptr->name, stop_ptr);
+		stop_buses_.emplace_back();
+		stops_distances_.emplace_back();
+		is_frozen_ = false;
+	}
+
+	const Stop* TransportCatalogue::FindStop(std::string_view stop) const
 	{
-		std::size_t PairStopHasher::operator()(const std::pair<const  Stop*, const  Stop*>& pair_stop) const
+		if (stopname_to_stop_.count(stop) == 0)
 		{
-			constexpr std::size_t hash_multiplier = 42;
+			return nullptr;
+		}
+		return stopname_to_stop_.at(stop);
+	}
 
-			// Вычисляем хеш для каждого указателя на Stop
-			std::size_t hash1 = 0;
-			std::size_t hash2 = 0;
+	StopId TransportCatalogue::GetStopId(std::string_view stop) const
+	{
+		return stopname_to_stop_.at(stop)->id;
+	}
 
-			for (char c : pair_stop.first->name)
-			{
-				hash1 = hash1 * hash_multiplier + c;
-			}
+	const Stop& TransportCatalogue::GetStop(StopId stop_id) const
+	{
+		return stops_.at(stop_id);
+	}
 
-			for (char c : pair_stop.second->name)
-			{
-				hash2 = hash2 * hash_multiplier + c;
-			}
+	size_t TransportCatalogue::GetStopCount() const
+	{
+		return stops_.size();
+	}
 
-			// Комбинируем хеши указателей в одно хеш-значение
-			return hash1 * hash_multiplier + hash2;
+	std::string_view TransportCatalogue::GetStopName(StopId stop_id) const
+	{
+		return stops_.at(stop_id).name;
+	}
+
+	geo::Coordinates TransportCatalogue::GetStopCoordinates(StopId stop_id) const
+	{
+		if (stop_id < arena_.stop_lats.size())
+		{
+			return { arena_.stop_lats[stop_id], arena_.stop_lngs[stop_id] };
 		}
-	}//namespace detail
+		return stops_.at(stop_id).coordinates;
+	}
 
-	void TransportCatalogue::AddStop(Stop stop)
+	std::string_view TransportCatalogue::GetBusName(BusId bus_id) const
 	{
-		stops_.push_back(std::move(stop));
-		Stop* stop_ptr = &stops_.back();
-		stopname_to_stop_.emplace(stop_ptr->name, stop_ptr);
+		return buses_.at(bus_id).name;
 	}
 
-	const Stop* TransportCatalogue::FindStop(std::string_view stop) const
+	TransportCatalogue::BusStopsRange TransportCatalogue::GetBusStops(BusId bus_id) const
 	{
-		if (stopname_to_stop_.count(stop) == 0)
+		const size_t frozen_bus_count = GetFrozenBusCount();
+		if (bus_id < frozen_bus_count)
 		{
-			return nullptr;
+			return BusStopsRange(arena_.bus_stops.begin() + arena_.bus_stop_offsets[bus_id],
+				arena_.bus_stops.begin() + arena_.bus_stop_offsets[bus_id + 1]);
 		}
-		return stopname_to_stop_.at(stop);
+		const std::vector<StopId>& stops = pending_bus_stops_.at(bus_id - frozen_bus_count);
+		return BusStopsRange(stops.begin(), stops.end());
 	}
 
-	std::set<std::string> TransportCatalogue::GetStopBuses(std::string_view stop) const
+	size_t TransportCatalogue::GetFrozenBusCount() const
 	{
-		if (stopname_to_busnames_.count(stop) == 0)
+		return arena_.bus_stop_offsets.empty() ? 0 : arena_.bus_stop_offsets.size() - 1;
+	}
+
+	TransportCatalogue::StopBusesRange TransportCatalogue::GetStopBuses(std::string_view stop) const
+	{
+		const Stop* stop_ptr = FindStop(stop);
+		if (stop_ptr == nullptr || stop_ptr->id + 1 >= stop_bus_offsets_.size())
 		{
-			return {};
+			return StopBusesRange(stop_bus_names_.end(), stop_bus_names_.end());
 		}
-		return stopname_to_busnames_.at(stop);
+		return StopBusesRange(stop_bus_names_.begin() + stop_bus_offsets_[stop_ptr->id],
+			stop_bus_names_.begin() + stop_bus_offsets_[stop_ptr->id + 1]);
+	}
+
+	const std::vector<BusId>& TransportCatalogue::GetStopBusIds(StopId stop_id) const
+	{
+		return stop_buses_.at(stop_id);
 	}
 
-	void TransportCatalogue::SetDistance(const std::string& stop, std::vector<std::pair<std::string, int>>& distances_to_stops)
+	void TransportCatalogue::SetDistance(std::string_view stop, std::vector<std::pair<std::string, int>>& distances_to_stops)
 	{
 		if (distances_to_stops.size() == 0)
 		{
 			return;
 		}
-		Stop* stop_ptr = stopname_to_stop_.at(stop);
+		const StopId stop_id = GetStopId(stop);
 		for (const auto& [stopname, distance] : distances_to_stops)
 		{
-			Stop* another_stop_ptr = stopname_to_stop_.at(stopname);
-			stops_distances_.emplace(std::make_pair(stop_ptr, another_stop_ptr), distance);
+			SetDistance(stop_id, GetStopId(stopname), distance);
 		}
 	}
 
-	void TransportCatalogue::SetDistance(const std::string& stop_from, const std::string& stop_to, int distance)
+	void TransportCatalogue::SetDistance(StopId stop_from, StopId stop_to, int distance)
 	{
-		Stop* Stop_from = stopname_to_stop_.at(stop_from);
-		Stop* Stop_to = stopname_to_stop_.at(stop_to);
-		stops_distances_.emplace(std::make_pair(Stop_from, Stop_to), distance);
+		if (stop_to >= stops_.size())
+		{
+			throw std::out_of_range("Stop id is out of range");
+		}
+		is_frozen_ = false;
+		// длины маршрутов через обе остановки могли измениться
+		for (const StopId stop_id : { stop_from, stop_to })
+		{
+			for (const BusId bus_id : stop_buses_.at(stop_id))
+			{
+				is_bus_info_actual_[bus_id] = false;
+			}
+		}
+		auto& distances = stops_distances_.at(stop_from);
+		auto it = std::find_if(distances.begin(), distances.end(), [stop_to](const auto& item)
+		{
+			return item.first == stop_to;
+		});
+		if (it != distances.end())
+		{
+			it->second = distance;
+		}
+		else
+		{
+			distances.emplace_back(stop_to, distance);
+		}
 	}
 
 	int TransportCatalogue::GetDistance(const Stop* stop_ptr, const Stop* anoter_stop_ptr) const
 	{
-		auto first_it = stops_distances_.find(std::make_pair(stop_ptr, anoter_stop_ptr));
-		auto second_it = stops_distances_.find(std::make_pair(anoter_stop_ptr, stop_ptr));
+		return GetDistance(stop_ptr->id, anoter_stop_ptr->id);
+	}
 
-		if (first_it != stops_distances_.end())
+	int TransportCatalogue::GetDistance(StopId stop_from, StopId stop_to) const
+	{
+		if (is_frozen_)
 		{
-			return stops_distances_.at(std::make_pair(stop_ptr, anoter_stop_ptr));
+			const auto first = distance_targets_.begin() + distance_offsets_[stop_from];
+			const auto last = distance_targets_.begin() + distance_offsets_[stop_from + 1];
+			const auto it = std::lower_bound(first, last, stop_to);
+			return it != last && *it == stop_to ? distance_values_[it - distance_targets_.begin()] : 0;
 		}
-		else if (second_it != stops_distances_.end())
+		for (const auto& [stop_id, distance] : stops_distances_[stop_from])
 		{
-			return stops_distances_.at(std::make_pair(anoter_stop_ptr, stop_ptr));
+			if (stop_id == stop_to)
+			{
+				return distance;
+			}
 		}
-		else
+		for (const auto& [stop_id, distance] : stops_distances_[stop_to])
 		{
-			return 0;
+			if (stop_id == stop_from)
+			{
+				return distance;
+			}
 		}
+		return 0;
 	}
 
-	void TransportCatalogue::AddBus(const std::string& bus_name, bool is_roundtrip, const std::vector<std::string>& bus_stops)
+	const std::vector<std::pair<StopId, int>>& TransportCatalogue::GetDistancesFrom(StopId stop_id) const
 	{
-		Bus bus_add;
-		std::vector<const Stop*> stops_view;
+		return stops_distances_.at(stop_id);
+	}
 
-		bus_add.name = bus_name;
-		bus_add.is_roundtrip = is_roundtrip;
+	void TransportCatalogue::AddBus(const std::string& bus_name, bool is_roundtrip, const std::vector<std::string>& bus_stops)
+	{
+		std::vector<StopId> stop_ids;
+		stop_ids.reserve(bus_stops.size());
 		for (const std::string& stop_name : bus_stops)
 		{
-			stops_view.push_back(FindStop(stop_name));
+			stop_ids.push_back(GetStopId(stop_name));
+		}
+		AddBus(bus_name, is_roundtrip, stop_ids);
+	}
+
+	void TransportCatalogue::AddBus(const std::string& bus_name, bool is_roundtrip, const std::vector<StopId>& bus_stops)
+	{
+		for (const StopId stop_id : bus_stops)
+		{
+			if (stop_id >= stops_.size())
+			{
+				throw std::out_of_range("Stop id is out of range");
+			}
 		}
-		bus_add.stops = stops_view;
+		Bus bus_add;
+		bus_add.name = pending_names_.emplace_back(bus_name);
+		bus_add.is_roundtrip = is_roundtrip;
+		bus_add.id = static_cast<BusId>(buses_.size());
 		buses_.push_back(bus_add);
+		pending_bus_stops_.push_back(bus_stops);
+		removed_buses_.push_back(false);
 		Bus* bus_ptr = &buses_.back();
+		bus_infos_.push_back(BusInfo{ bus_ptr->name });
+		is_bus_info_actual_.push_back(false);
 		busname_to_bus_.emplace(bus_ptr->name, bus_ptr);
-		for (const Stop* stop : stops_view)
+		// списки автобусов остановок держим упорядоченными по имени, без повторов
+		for (const StopId stop_id : bus_stops)
 		{
-			stopname_to_busnames_[stop->name].insert(bus_ptr->name);
+			auto& stop_buses = stop_buses_[stop_id];
+			auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus_ptr->name, [this](BusId bus_id, std::string_view name)
+			{
+				return buses_[bus_id].name < name;
+			});
+			if (it == stop_buses.end() || *it != bus_ptr->id)
+			{
+				stop_buses.insert(it, bus_ptr->id);
+			}
 		}
 	}
 
+	bool TransportCatalogue::RemoveBus(std::string_view bus_name)
+	{
+		auto bus_it = busname_to_bus_.find(bus_name);
+		if (bus_it == busname_to_bus_.end())
+		{
+			return false;
+		}
+		const Bus* bus = bus_it->second;
+		for (const StopId stop_id : GetBusStops(bus->id))
+		{
+			auto& stop_buses = stop_buses_[stop_id];
+			stop_buses.erase(std::remove(stop_buses.begin(), stop_buses.end(), bus->id), stop_buses.end());
+		}
+		removed_buses_[bus->id] = true;
+		busname_to_bus_.erase(bus_it);
+		return true;
+	}
+
 	const Bus* TransportCatalogue::FindBus(std::string_view bus) const
 	{
 		if (busname_to_bus_.count(bus) == 0)
@@ -125,74 +251,253 @@ namespace transport_catalogue
 		return busname_to_bus_.at(bus);
 	}
 
-	std::optional <BusInfo> TransportCatalogue::GetBusInfo(std::string_view bus_name) const
+	const Bus& TransportCatalogue::GetBus(BusId bus_id) const
 	{
-		BusInfo bus_info;
-		double compute_length = 0;
-		int get_distance_length = 0;
-		const Bus* bus = FindBus(bus_name);
+		return buses_.at(bus_id);
+	}
+
+	size_t TransportCatalogue::GetBusCount() const
+	{
+		return buses_.size();
+	}
+
+	bool TransportCatalogue::IsBusRemoved(BusId bus_id) const
+	{
+		return removed_buses_.at(bus_id);
+	}
 
+	const BusInfo* TransportCatalogue::GetBusInfo(std::string_view bus_name) const
+	{
+		const Bus* bus = FindBus(bus_name);
 		if (bus == nullptr)
 		{
-			return {};
+			return nullptr;
 		}
-		bus_info.name = bus_name;
-		std::vector<const Stop*> stops_view = bus->stops;
-		if (stops_view.size() == 0)
+		return &bus_infos_[bus->id];
+	}
+
+	void TransportCatalogue::SetBusInfo(BusId bus_id, const BusInfo& bus_info)
+	{
+		bus_infos_.at(bus_id) = bus_info;
+		bus_infos_[bus_id].name = buses_[bus_id].name;
+		is_bus_info_actual_[bus_id] = true;
+	}
+
+	const std::unordered_map<std::string_view, Bus*>& TransportCatalogue::GetBusnameToBus() const
+	{
+		return busname_to_bus_;
+	}
+
+	const std::unordered_map<std::string_view, Stop*>& TransportCatalogue::GetStopnameToStop() const
+	{
+		return stopname_to_stop_;
+	}
+
+	void TransportCatalogue::Freeze()
+	{
+		BuildArena();
+		BuildDistanceIndex();
+		BuildStopBusesIndex();
+		is_frozen_ = true;
+		UpdateBusInfos();
+	}
+
+	void TransportCatalogue::BuildArena()
+	{
+		// новый снимок собирается из старого и добавленного после него, поэтому подменяет
+		// старый только целиком
+		Arena arena;
+		std::vector<uint32_t> name_offsets;
+		name_offsets.reserve(stops_.size() + buses_.size() + 1);
+		name_offsets.push_back(0);
+		arena.stop_lats.reserve(stops_.size());
+		arena.stop_lngs.reserve(stops_.size());
+		for (const Stop& stop : stops_)
 		{
-			return bus_info;
+			arena.names += stop.name;
+			name_offsets.push_back(static_cast<uint32_t>(arena.names.size()));
+			arena.stop_lats.push_back(stop.coordinates.lat);
+			arena.stop_lngs.push_back(stop.coordinates.lng);
 		}
-		for (size_t i = 0; i < stops_view.size() - 1; ++i)
+		arena.bus_stop_offsets.reserve(buses_.size() + 1);
+		arena.bus_stop_offsets.push_back(0);
+		for (const Bus& bus : buses_)
 		{
-			const Stop* current_stop = stops_view[i];
-			const Stop* next_stop = stops_view[i + 1];
-			compute_length += ComputeDistance(current_stop->coordinates, next_stop->coordinates);
-			get_distance_length += GetDistance(current_stop, next_stop);
+			arena.names += bus.name;
+			name_offsets.push_back(static_cast<uint32_t>(arena.names.size()));
+			if (!removed_buses_[bus.id])
+			{
+				const BusStopsRange stops = GetBusStops(bus.id);
+				arena.bus_stops.insert(arena.bus_stops.end(), stops.begin(), stops.end());
+			}
+			arena.bus_stop_offsets.push_back(static_cast<uint32_t>(arena.bus_stops.size()));
 		}
+		arena_ = std::move(arena);
+		pending_bus_stops_.clear();
 
-		if (bus->is_roundtrip)
+		// имена переводятся на снимок только после перемещения: короткая строка
+		// при перемещении копируется в новый буфер
+		const std::string_view names = arena_.names;
+		size_t name_index = 0;
+		stopname_to_stop_.clear();
+		for (Stop& stop : stops_)
 		{
-			bus_info.amount_stops = stops_view.size();
+			stop.name = names.substr(name_offsets[name_index], name_offsets[name_index + 1] - name_offsets[name_index]);
+			++name_index;
+			stopname_to_stop_.emplace(stop.name, &stop);
 		}
-		else
+		busname_to_bus_.clear();
+		for (Bus& bus : buses_)
 		{
-			bus_info.amount_stops = stops_view.size() * 2 - 1;
-			compute_length += compute_length;
-			for (auto it = stops_view.rbegin(); it != stops_view.rend(); ++it)
+			bus.name = names.substr(name_offsets[name_index], name_offsets[name_index + 1] - name_offsets[name_index]);
+			++name_index;
+			bus_infos_[bus.id].name = bus.name;
+			if (!removed_buses_[bus.id])
 			{
-				if (it != stops_view.rbegin())
-				{
-					const Stop* r_current_stop = *it;
-					const Stop* r_next_stop = *(it - 1);
-					get_distance_length += GetDistance(r_next_stop, r_current_stop);
-				}
+				busname_to_bus_.emplace(bus.name, &bus);
 			}
 		}
-		std::unordered_set<const Stop*> uniq_stops(stops_view.begin(), stops_view.end());
-
-		bus_info.uniq_stops = uniq_stops.size();
-		bus_info.route_length = get_distance_length;
-		bus_info.curvature = get_distance_length / compute_length;
-		return bus_info;
+		pending_names_.clear();
 	}
 
-	const std::unordered_map<std::string_view, Bus*>& TransportCatalogue::GetBusnameToBus() const
+	void TransportCatalogue::BuildDistanceIndex()
 	{
-		return busname_to_bus_;
+		struct DistanceItem
+		{
+			StopId from;
+			StopId to;
+			bool is_reverse;  // подставлено из обратного направления
+			int distance;
+		};
+		std::vector<DistanceItem> items;
+		for (StopId stop_from = 0; stop_from < stops_distances_.size(); ++stop_from)
+		{
+			for (const auto& [stop_to, distance] : stops_distances_[stop_from])
+			{
+				items.push_back({ stop_from, stop_to, false, distance });
+				items.push_back({ stop_to, stop_from, true, distance });
+			}
+		}
+		// заданное прямое расстояние оказывается перед подставленным обратным и вытесняет его
+		std::sort(items.begin(), items.end(), [](const DistanceItem& left, const DistanceItem& right)
+		{
+			return std::tie(left.from, left.to, left.is_reverse) < std::tie(right.from, right.to, right.is_reverse);
+		});
+		items.erase(std::unique(items.begin(), items.end(), [](const DistanceItem& left, const DistanceItem& right)
+		{
+			return left.from == right.from && left.to == right.to;
+		}), items.end());
+
+		distance_offsets_.assign(stops_.size() + 1, 0);
+		distance_targets_.clear();
+		distance_targets_.reserve(items.size());
+		distance_values_.clear();
+		distance_values_.reserve(items.size());
+		for (const DistanceItem& item : items)
+		{
+			++distance_offsets_[item.from + 1];
+			distance_targets_.push_back(item.to);
+			distance_values_.push_back(item.distance);
+		}
+		for (size_t i = 1; i < distance_offsets_.size(); ++i)
+		{
+			distance_offsets_[i] += distance_offsets_[i - 1];
+		}
 	}
 
-	const std::unordered_map<std::string_view, Stop*>& TransportCatalogue::GetStopnameToStop() const
+	void TransportCatalogue::BuildStopBusesIndex()
 	{
-		return stopname_to_stop_;
+		stop_bus_offsets_.assign(1, 0);
+		stop_bus_offsets_.reserve(stops_.size() + 1);
+		stop_bus_names_.clear();
+		for (const auto& stop_buses : stop_buses_)
+		{
+			for (const BusId bus_id : stop_buses)
+			{
+				stop_bus_names_.push_back(GetBusName(bus_id));
+			}
+			stop_bus_offsets_.push_back(static_cast<uint32_t>(stop_bus_names_.size()));
+		}
 	}
 
-	const std::unordered_map<std::string_view, std::set<std::string>>& TransportCatalogue::GetStopnameToBusnames() const
+	void TransportCatalogue::UpdateBusInfos()
 	{
-		return stopname_to_busnames_;
+		std::vector<BusId> outdated_buses;
+		for (BusId bus_id = 0; bus_id < buses_.size(); ++bus_id)
+		{
+			if (!removed_buses_[bus_id] && !is_bus_info_actual_[bus_id])
+			{
+				outdated_buses.push_back(bus_id);
+			}
+		}
+		if (outdated_buses.empty())
+		{
+			return;
+		}
+		// каждая задача пишет только в статистику своих автобусов, расстояния уже заморожены
+		constexpr size_t BUS_INFOS_PER_TASK = 64;
+		const auto compute_bus_infos = [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				bus_infos_[outdated_buses[i]] = ComputeBusInfo(buses_[outdated_buses[i]]);
+			}
+		};
+		const size_t tasks_count = (outdated_buses.size() + BUS_INFOS_PER_TASK - 1) / BUS_INFOS_PER_TASK;
+		if (tasks_count == 1)
+		{
+			// обычное обновление базы меняет несколько автобусов: потоки для одной задачи не нужны
+			compute_bus_infos(0, outdated_buses.size());
+		}
+		else
+		{
+			const size_t hardware_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+			parallel::ThreadPool pool(std::min(tasks_count, hardware_threads));
+			pool.ParallelFor(0, outdated_buses.size(), BUS_INFOS_PER_TASK, compute_bus_infos);
+		}
+		for (const BusId bus_id : outdated_buses)
+		{
+			is_bus_info_actual_[bus_id] = true;
+		}
 	}
 
-	const std::unordered_map<std::pair<const Stop*, const Stop*>, int, detail::PairStopHasher>& TransportCatalogue::GetDistances() const
+	BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) const
 	{
-		return stops_distances_;
+		BusInfo bus_info;
+		bus_info.name = bus.name;
+		const BusStopsRange stops = GetBusStops(bus.id);
+		if (stops.empty())
+		{
+			return bus_info;
+		}
+		double compute_length = 0;
+		int get_distance_length = 0;
+		for (size_t i = 0; i + 1 < stops.size(); ++i)
+		{
+			compute_length += ComputeDistance(GetStopCoordinates(stops[i]), GetStopCoordinates(stops[i + 1]));
+			get_distance_length += GetDistance(stops[i], stops[i + 1]);
+		}
+
+		if (bus.is_roundtrip)
+		{
+			bus_info.amount_stops = stops.size();
+		}
+		else
+		{
+			bus_info.amount_stops = stops.size() * 2 - 1;
+			compute_length += compute_length;
+			// обратный путь проходится по расстояниям в обратном направлении
+			for (size_t i = stops.size() - 1; i > 0; --i)
+			{
+				get_distance_length += GetDistance(stops[i], stops[i - 1]);
+			}
+		}
+		std::vector<StopId> stop_ids(stops.begin(), stops.end());
+		std::sort(stop_ids.begin(), stop_ids.end());
+
+		bus_info.uniq_stops = static_cast<int>(std::unique(stop_ids.begin(), stop_ids.end()) - stop_ids.begin());
+		bus_info.route_length = get_distance_length;
+		bus_info.curvature = get_distance_length / compute_length;
+		return bus_info;
 	}
 }//namespace transport_catalogue
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "geo.h"
 #include "domain.h"
+#include "ranges.h"
 
 #include <vector>
 #include <deque>
@@ -9,56 +10,150 @@
 #include <string_view>
 #include <unordered_set>
 #include <iostream>
-#include <set>
-#include <optional>
 
 namespace transport_catalogue
 {
-	namespace detail
-	{
-		struct PairStopHasher
-		{
-			std::size_t operator()(const std::pair<const Stop*, const Stop*>& pair_stop) const;
-		};
-	}// namespace detail
-
+	// Остановки и автобусы нумеруются подряд при добавлении (StopId, BusId), и всё, что к ним
+	// относится, хранится в векторах по номерам. Имена нужны только для поиска по запросам.
+	// Наполненный справочник замораживается (Freeze): имена и остановки маршрутов переезжают
+	// в единственную копию - снимок в непрерывных массивах, на который ссылаются Stop::name,
+	// Bus::name и ключи словарей имён. Расстояния остаются и в изменяемом виде для
+	// обновления базы и сериализации
 	class TransportCatalogue final
 	{
 	public:
+		// остановка получает следующий свободный номер, поле stop.id перезаписывается
 		void AddStop(Stop stop);
 
 		const Stop* FindStop(std::string_view stop) const;
 
-		std::set<std::string> GetStopBuses(std::string_view stop) const;
+		// номер остановки по имени; std::out_of_range, если такой остановки нет
+		StopId GetStopId(std::string_view stop) const;
+
+		const Stop& GetStop(StopId stop_id) const;
+
+		size_t GetStopCount() const;
+
+		using BusStopsRange = ranges::Range<std::vector<StopId>::const_iterator>;
+
+		// Виды действительны до следующего Freeze: он переносит данные, добавленные после
+		// прошлого снимка, в новый
+		std::string_view GetStopName(StopId stop_id) const;
+		geo::Coordinates GetStopCoordinates(StopId stop_id) const;
+		std::string_view GetBusName(BusId bus_id) const;
+		// остановки маршрута в порядке следования; у удалённого автобуса диапазон пуст после Freeze
+		BusStopsRange GetBusStops(BusId bus_id) const;
+
+		using StopBusesRange = ranges::Range<std::vector<std::string_view>::const_iterator>;
+
+		// имена автобусов через остановку по возрастанию, без копирования: вид на снимок,
+		// собранный Freeze, действителен до следующего изменения справочника. Для
+		// неизвестной остановки диапазон пуст
+		StopBusesRange GetStopBuses(std::string_view stop) const;
+
+		// автобусы, проходящие через остановку, по возрастанию имени
+		const std::vector<BusId>& GetStopBusIds(StopId stop_id) const;
 
-		void SetDistance(const std::string& stop, std::vector<std::pair<std::string, int>>& distances_to_stops);
+		void SetDistance(std::string_view stop, std::vector<std::pair<std::string, int>>& distances_to_stops);
 
-		void SetDistance(const std::string& stop_from, const std::string& stop_to, int distance);
+		// повторное задание расстояния, например при обновлении базы, заменяет прежнее.
+		// Снимок расстояний сбрасывается до следующего Freeze
+		void SetDistance(StopId stop_from, StopId stop_to, int distance);
 
 		int GetDistance(const Stop* stop_ptr, const Stop* anoter_stop_ptr) const;
 
+		// расстояние from -> to, а если оно не задано - to -> from; 0, если не задано ни одно.
+		// После Freeze - двоичный поиск по снимку, до него - перебор заданных расстояний
+		int GetDistance(StopId stop_from, StopId stop_to) const;
+
+		// заданные от остановки расстояния: номер соседней остановки и расстояние до неё
+		const std::vector<std::pair<StopId, int>>& GetDistancesFrom(StopId stop_id) const;
+
 		void AddBus(const std::string& bus_name, bool is_roundtrip, const std::vector<std::string>& bus_stops);
 
+		void AddBus(const std::string& bus_name, bool is_roundtrip, const std::vector<StopId>& bus_stops);
+
+		// убирает автобус из справочника; false, если такого нет. Сам объект и его номер остаются
+		// в хранилище: на его имя могут ссылаться string_view, а на номер - веса рёбер графа маршрутов
+		bool RemoveBus(std::string_view bus_name);
+
 		const Bus* FindBus(std::string_view bus) const;
 
-		std::optional <BusInfo> GetBusInfo(std::string_view bus) const;
+		const Bus& GetBus(BusId bus_id) const;
+
+		// число выданных номеров автобусов вместе с номерами удалённых
+		size_t GetBusCount() const;
+
+		bool IsBusRemoved(BusId bus_id) const;
+
+		// статистика автобуса из таблицы, собранной Freeze; nullptr, если такого автобуса нет
+		const BusInfo* GetBusInfo(std::string_view bus) const;
+
+		// статистика автобуса, сохранённая вместе с базой: при загрузке Freeze её не пересчитывает
+		void SetBusInfo(BusId bus_id, const BusInfo& bus_info);
 
 		const std::unordered_map<std::string_view, Bus*>& GetBusnameToBus() const;
 
 		const std::unordered_map<std::string_view, Stop*>& GetStopnameToStop() const;
 
-		const std::unordered_map<std::string_view, std::set<std::string>>& GetStopnameToBusnames() const;
-
-		const std::unordered_map<std::pair<const Stop*, const Stop*>, int, detail::PairStopHasher>& GetDistances() const;
+		// Собирает снимок для запросов после загрузки или изменения справочника. Вызывается
+		// после наполнения базы, её загрузки из файла и применения обновлений. Статистика
+		// пересчитывается параллельно только для новых автобусов и автобусов через остановки
+		// с изменёнными расстояниями
+		void Freeze();
 
 	private:
 		std::deque<Bus> buses_;
+		std::vector<bool> removed_buses_;
 		std::unordered_map<std::string_view, Bus*> busname_to_bus_;
 
 		std::deque<Stop> stops_;
 		std::unordered_map<std::string_view, Stop*> stopname_to_stop_;
-		std::unordered_map<std::string_view, std::set<std::string>> stopname_to_busnames_;
 
-		std::unordered_map<std::pair<const Stop*, const Stop*>, int, detail::PairStopHasher> stops_distances_;
+		// по номеру остановки: автобусы через неё и заданные от неё расстояния
+		std::vector<std::vector<BusId>> stop_buses_;
+		std::vector<std::vector<std::pair<StopId, int>>> stops_distances_;
+
+		// Снимок расстояний в виде CSR: соседи остановки i лежат в distance_targets_ на отрезке
+		// [distance_offsets_[i], distance_offsets_[i + 1]) по возрастанию номера. Обратные
+		// направления, для которых прямое расстояние не задано, уже подставлены
+		std::vector<uint32_t> distance_offsets_;
+		std::vector<StopId> distance_targets_;
+		std::vector<int> distance_values_;
+		bool is_frozen_ = false;
+
+		// статистика по номеру автобуса; устаревшая пересчитывается при следующем Freeze
+		std::vector<BusInfo> bus_infos_;
+		std::vector<bool> is_bus_info_actual_;
+
+		// Снимок справочника: имена остановок, затем автобусов одной строкой, координаты
+		// остановок раздельными массивами, остановки всех маршрутов подряд. Остановки
+		// автобуса i лежат на отрезке [bus_stop_offsets[i], bus_stop_offsets[i + 1])
+		struct Arena
+		{
+			std::string names;
+			std::vector<double> stop_lats;
+			std::vector<double> stop_lngs;
+			std::vector<uint32_t> bus_stop_offsets;
+			std::vector<StopId> bus_stops;
+		};
+		Arena arena_;
+
+		// Добавленное после последнего Freeze: имена, на которые пока ссылаются Stop::name и
+		// Bus::name, и остановки автобусов с номерами от числа автобусов в снимке
+		std::deque<std::string> pending_names_;
+		std::vector<std::vector<StopId>> pending_bus_stops_;
+
+		// имена автобусов через остановку i лежат в stop_bus_names_ на отрезке
+		// [stop_bus_offsets_[i], stop_bus_offsets_[i + 1])
+		std::vector<uint32_t> stop_bus_offsets_;
+		std::vector<std::string_view> stop_bus_names_;
+
+		void BuildArena();
+		size_t GetFrozenBusCount() const;
+		void BuildDistanceIndex();
+		void BuildStopBusesIndex();
+		void UpdateBusInfos();
+		BusInfo ComputeBusInfo(const Bus& bus) const;
 	};
 }//namespace transport_catalogue
\ No newline at end of file
@@ -1,45 +1,526 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <unordered_set>
+
 namespace transport_catalogue
 {
-	bool operator<(const RouteWeight& left, const RouteWeight& right)
+	TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, const RoutingSettings& settings)
+		: catalogue_(catalogue)
+		, settings_(settings)
 	{
-		return left.total_time < right.total_time;
+		if (settings_.route_cache_capacity > 0)
+		{
+			route_cache_ = std::make_unique<RouteCache>(static_cast<size_t>(settings_.route_cache_capacity));
+		}
 	}
 
-	RouteWeight operator+(const RouteWeight& left, const RouteWeight& right)
+	size_t TransportRouter::RouteIdsHasher::operator()(const std::pair<graph::VertexId, graph::VertexId>& ids) const
 	{
-		RouteWeight result;
-		result.total_time = left.total_time + right.total_time;
-		return result;
+		constexpr size_t hash_multiplier = 1'000'003;
+		return ids.first * hash_multiplier + ids.second;
 	}
 
-	bool operator>(const RouteWeight& left, const RouteWeight& right)
+	void TransportRouter::InitRouter(const graph::ProgressCallback& progress)
 	{
-		return left.total_time > right.total_time;
+		if (!is_initialized_)
+		{
+			const size_t stops_count = catalogue_.GetStopCount();
+			if (settings_.router_type == RouterType::RAPTOR)
+			{
+				// RAPTOR работает прямо по маршрутам автобусов, граф ему не нужен
+			}
+			else if (settings_.graph_model == GraphModel::TRANSFER)
+			{
+				GraphBuilder graph(stops_count + CountRideVertices());
+				BuildTransferEdges(graph, stops_count);
+				graph_ = Graph(graph);
+			}
+			else
+			{
+				GraphBuilder graph(stops_count);
+				BuildEdges(graph);
+				graph_ = Graph(graph);
+			}
+			if (settings_.router_type != RouterType::RAPTOR && !settings_.hot_stops.empty())
+			{
+				// строки матрицы только для горячих остановок: быстрый путь для частых отправлений
+				// при памяти O(H·V); из остальных остановок маршрут ищется по запросу
+				const auto hot_stop_ids = GetHotStopIds();
+				if (!hot_stop_ids.empty())
+				{
+					router_ = std::make_unique<Router>(graph_, hot_stop_ids, 0, progress);
+				}
+			}
+			else if (settings_.router_type == RouterType::ALL_PAIRS)
+			{
+				router_ = std::make_unique<Router>(graph_, true, 0, settings_.all_pairs_method, progress);
+			}
+			if (settings_.router_type == RouterType::CONTRACTION_HIERARCHY)
+			{
+				contraction_hierarchy_ = std::make_unique<ContractionHierarchy>(graph_);
+			}
+			else if (settings_.router_type == RouterType::ALT)
+			{
+				landmarks_ = std::make_unique<Landmarks>(graph_, SelectLandmarks());
+			}
+			if (settings_.hub_labels && settings_.router_type != RouterType::RAPTOR)
+			{
+				hub_labels_ = std::make_unique<HubLabels>(graph_);
+			}
+			InitSearchEngines();
+			is_initialized_ = true;
+		}
 	}
 
-	TransportRouter::TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, const RoutingSettings& settings)
-		: catalogue_(catalogue)
-		, settings_(settings)
+	void TransportRouter::InternalInit()
+	{
+		InitSearchEngines();
+		is_initialized_ = true;
+	}
+
+	void TransportRouter::Rebuild(const graph::ProgressCallback& progress)
 	{
+		is_initialized_ = false;
+		router_.reset();
+		contraction_hierarchy_.reset();
+		landmarks_.reset();
+		hub_labels_.reset();
+		InitRouter(progress);
+		if (route_cache_)
+		{
+			route_cache_ = std::make_unique<RouteCache>(static_cast<size_t>(settings_.route_cache_capacity));
+		}
 	}
 
-	void TransportRouter::InitRouter()
+	size_t TransportRouter::AllocateRideVertices(const std::vector<const Bus*>& buses, const std::vector<bool>& is_used_vertex,
+		std::vector<graph::VertexId>& first_ride_vertices, size_t& vertex_count) const
 	{
+		// свободные отрезки номеров вершин поездки: начало и длина
+		std::vector<std::pair<graph::VertexId, size_t>> free_ranges;
+		for (graph::VertexId vertex = catalogue_.GetStopCount(); vertex < is_used_vertex.size(); ++vertex)
+		{
+			if (is_used_vertex[vertex])
+			{
+				continue;
+			}
+			if (!free_ranges.empty() && free_ranges.back().first + free_ranges.back().second == vertex)
+			{
+				++free_ranges.back().second;
+			}
+			else
+			{
+				free_ranges.push_back({ vertex, 1 });
+			}
+		}
+		// вершины поездки автобуса идут подряд, поэтому ему нужен отрезок целиком: первый подходящий
+		first_ride_vertices.clear();
+		for (const Bus* bus : buses)
+		{
+			const size_t ride_vertices_count = CountRideVertices(*bus);
+			auto it = std::find_if(free_ranges.begin(), free_ranges.end(), [ride_vertices_count](const auto& range)
+			{
+				return range.second >= ride_vertices_count;
+			});
+			if (it != free_ranges.end())
+			{
+				first_ride_vertices.push_back(it->first);
+				it->first += ride_vertices_count;
+				it->second -= ride_vertices_count;
+			}
+			else
+			{
+				first_ride_vertices.push_back(static_cast<graph::VertexId>(vertex_count));
+				vertex_count += ride_vertices_count;
+			}
+		}
+		size_t free_vertices_count = 0;
+		for (const auto& [first, count] : free_ranges)
+		{
+			free_vertices_count += count;
+		}
+		return free_vertices_count;
+	}
+
+	TransportRouter::UpdateStatistics TransportRouter::UpdateBuses(const std::vector<std::string>& bus_names,
+		const graph::ProgressCallback& progress)
+	{
+		UpdateStatistics result;
 		if (!is_initialized_)
 		{
-			graph::DirectedWeightedGraph<RouteWeight>graph(CountStops());
-			graph_ = std::move(graph);
-			BuildEdges();
-			router_ = std::make_unique<graph::Router<RouteWeight>>(graph_);
-			is_initialized_ = true;
+			// чинить нечего: граф и индексы сразу строятся по текущему справочнику
+			InitRouter(progress);
+			return result;
+		}
+		if (settings_.router_type != RouterType::RAPTOR)
+		{
+			// рёбра изменённых автобусов удаляются, остальные переносятся в новый граф в прежнем
+			// порядке. У TRANSFER вершины поездки новых маршрутов занимают освободившиеся отрезки
+			// номеров, а если подходящего нет - добавляются в конец
+			// прежние версии заменённых и удалённых автобусов остались в справочнике под своими
+			// номерами с отметкой об удалении; автобусы с новыми расстояниями сохранили номера
+			std::vector<bool> is_changed(catalogue_.GetBusCount(), false);
+			std::vector<const Bus*> buses;
+			for (const std::string& name : bus_names)
+			{
+				const Bus* bus = catalogue_.FindBus(name);
+				if (bus && !is_changed[bus->id])
+				{
+					is_changed[bus->id] = true;
+					buses.push_back(bus);
+				}
+			}
+
+			std::vector<bool> is_kept_edge(graph_.GetEdgeCount(), false);
+			std::vector<bool> is_used_vertex(graph_.GetVertexCount(), false);
+			for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+			{
+				const auto edge = graph_.GetEdge(edge_id);
+				if (!catalogue_.IsBusRemoved(edge.weight.bus_id) && !is_changed[edge.weight.bus_id])
+				{
+					is_kept_edge[edge_id] = true;
+					is_used_vertex[edge.from] = true;
+					is_used_vertex[edge.to] = true;
+				}
+			}
+			size_t vertex_count = graph_.GetVertexCount();
+			std::vector<graph::VertexId> first_ride_vertices;
+			if (settings_.graph_model == GraphModel::TRANSFER)
+			{
+				const size_t free_vertices_count = AllocateRideVertices(buses, is_used_vertex, first_ride_vertices, vertex_count);
+				// вершины без рёбер остаются в графе и в матрице маршрутов; когда их становится
+				// много, граф дешевле построить заново
+				if (free_vertices_count > (vertex_count - catalogue_.GetStopCount()) * MAX_FREE_RIDE_VERTICES_SHARE)
+				{
+					result.removed_edges = graph_.GetEdgeCount();
+					Rebuild(progress);
+					result.added_edges = graph_.GetEdgeCount();
+					result.is_rebuilt = true;
+					return result;
+				}
+			}
+
+			GraphBuilder graph(vertex_count);
+			std::vector<graph::EdgeId> new_edge_ids(graph_.GetEdgeCount(), Router::NO_EDGE);
+			for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+			{
+				if (is_kept_edge[edge_id])
+				{
+					new_edge_ids[edge_id] = graph.AddEdge(graph_.GetEdge(edge_id));
+				}
+				else
+				{
+					++result.removed_edges;
+				}
+			}
+			const size_t kept_edges_count = graph.GetEdgeCount();
+			for (size_t i = 0; i < buses.size(); ++i)
+			{
+				if (settings_.graph_model == GraphModel::TRANSFER)
+				{
+					graph::VertexId ride_vertex = first_ride_vertices[i];
+					AddBusRideChains(graph, buses[i], ride_vertex);
+				}
+				else
+				{
+					AddBusEdges(graph, buses[i]);
+				}
+			}
+			result.added_edges = graph.GetEdgeCount() - kept_edges_count;
+			// при заморозке рёбра перенумеровываются по началу
+			const auto frozen_edge_ids = Graph::MapEdgeIds(graph);
+			for (auto& edge_id : new_edge_ids)
+			{
+				if (edge_id != Router::NO_EDGE)
+				{
+					edge_id = frozen_edge_ids[edge_id];
+				}
+			}
+			graph_ = Graph(graph);
+
+			if (router_)
+			{
+				result.repaired_rows = router_->Repair(new_edge_ids, 0, progress);
+			}
+			if (contraction_hierarchy_)
+			{
+				contraction_hierarchy_ = std::make_unique<ContractionHierarchy>(graph_);
+			}
+			if (landmarks_)
+			{
+				landmarks_ = std::make_unique<Landmarks>(graph_, SelectLandmarks());
+			}
+			if (hub_labels_)
+			{
+				hub_labels_ = std::make_unique<HubLabels>(graph_);
+			}
 		}
+		InitSearchEngines();
+		if (route_cache_)
+		{
+			route_cache_ = std::make_unique<RouteCache>(static_cast<size_t>(settings_.route_cache_capacity));
+		}
+		return result;
 	}
 
-	void TransportRouter::InternalInit()
+	void TransportRouter::InitSearchEngines()
 	{
-		is_initialized_ = true;
+		// движки без предрасчёта не сериализуются и создаются поверх готового графа.
+		// RAPTOR дёшев в построении и нужен всем движкам для многокритериальных запросов.
+		// Поиск Дейкстры по графу нужен всем движкам, кроме RAPTOR: им строятся зоны
+		// доступности, а при поиске не полной матрицей - и деревья для пакетных запросов.
+		// По тому же графу ищутся альтернативные маршруты
+		raptor_router_ = std::make_unique<RaptorRouter>(catalogue_, settings_.wait_time, settings_.velocity);
+		if (settings_.router_type != RouterType::RAPTOR)
+		{
+			dijkstra_router_ = std::make_unique<DijkstraRouter>(graph_);
+			k_shortest_paths_ = std::make_unique<KShortestPaths>(graph_);
+		}
+		if (settings_.router_type == RouterType::A_STAR)
+		{
+			InitTimeLowerBound();
+		}
+	}
+
+	void TransportRouter::InitTimeLowerBound()
+	{
+		const size_t stops_count = catalogue_.GetStopCount();
+		vertex_coordinates_.assign(graph_.GetVertexCount(), geo::Coordinates{});
+		for (StopId id = 0; id < stops_count; ++id)
+		{
+			vertex_coordinates_[id] = catalogue_.GetStopCoordinates(id);
+		}
+		// вершины поездки модели с пересадками находятся там же, где остановки посадки и высадки
+		for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+		{
+			const auto edge = graph_.GetEdge(edge_id);
+			if (edge.from < stops_count && edge.to >= stops_count)
+			{
+				vertex_coordinates_[edge.to] = vertex_coordinates_[edge.from];
+			}
+			else if (edge.from >= stops_count && edge.to < stops_count)
+			{
+				vertex_coordinates_[edge.from] = vertex_coordinates_[edge.to];
+			}
+		}
+
+		// Дорожные расстояния могут быть короче расстояний на сфере, поэтому оценка
+		// "расстояние / скорость" не всегда допустима. Вместо этого берём минимальное по всем
+		// рёбрам время на метр: тогда для любого ребра u->v оценка u не больше веса ребра
+		// плюс оценка v, и A* остаётся точным
+		std::optional<double> min_time_per_meter;
+		for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+		{
+			const auto edge = graph_.GetEdge(edge_id);
+			const double distance = geo::ComputeDistance(vertex_coordinates_[edge.from], vertex_coordinates_[edge.to]);
+			if (distance > 0)
+			{
+				const double time_per_meter = edge.weight.total_time / distance;
+				if (!min_time_per_meter || time_per_meter < *min_time_per_meter)
+				{
+					min_time_per_meter = time_per_meter;
+				}
+			}
+		}
+		// запас на погрешность вычисления расстояний
+		constexpr double ROUNDING_MARGIN = 1.0 - 1e-9;
+		min_time_per_meter_ = min_time_per_meter.value_or(0) * ROUNDING_MARGIN;
+	}
+
+	double TransportRouter::ComputeTimeLowerBound(graph::VertexId vertex, const geo::Coordinates& target) const
+	{
+		const double distance = geo::ComputeDistance(vertex_coordinates_[vertex], target);
+		return distance > 0 ? distance * min_time_per_meter_ : 0;
+	}
+
+	std::vector<graph::VertexId> TransportRouter::SelectLandmarks() const
+	{
+		// Опорные остановки выбираются по секторам вокруг центра сети: в каждом секторе
+		// самая удалённая от центра. Оценки точнее всего для путей "в сторону" опорной
+		// вершины, поэтому они должны лежать на окраинах и по разные стороны от центра
+		const size_t stops_count = catalogue_.GetStopCount();
+		const size_t landmarks_count = std::min(stops_count, static_cast<size_t>(std::max(settings_.landmarks_count, 0)));
+		if (landmarks_count == 0)
+		{
+			return {};
+		}
+		geo::Coordinates center{ 0, 0 };
+		for (StopId id = 0; id < stops_count; ++id)
+		{
+			const geo::Coordinates coordinates = catalogue_.GetStopCoordinates(id);
+			center.lat += coordinates.lat / stops_count;
+			center.lng += coordinates.lng / stops_count;
+		}
+
+		std::vector<std::pair<double, graph::VertexId>> stops_by_distance;
+		stops_by_distance.reserve(stops_count);
+		for (StopId id = 0; id < stops_count; ++id)
+		{
+			stops_by_distance.push_back({ geo::ComputeDistance(center, catalogue_.GetStopCoordinates(id)), id });
+		}
+		// от дальних к ближним; при равных расстояниях порядок задаёт номер вершины
+		std::sort(stops_by_distance.begin(), stops_by_distance.end(), [](const auto& left, const auto& right)
+		{
+			return left.first != right.first ? left.first > right.first : left.second < right.second;
+		});
+
+		constexpr double FULL_TURN = 2 * 3.14159265358979323846;
+		std::vector<bool> is_sector_used(landmarks_count, false);
+		std::vector<bool> is_selected(stops_count, false);
+		std::vector<graph::VertexId> landmarks;
+		landmarks.reserve(landmarks_count);
+		for (const auto& [distance, id] : stops_by_distance)
+		{
+			const geo::Coordinates coordinates = catalogue_.GetStopCoordinates(static_cast<StopId>(id));
+			const double angle = std::atan2(coordinates.lat - center.lat, coordinates.lng - center.lng) + FULL_TURN / 2;
+			const size_t sector = std::min(static_cast<size_t>(angle / FULL_TURN * landmarks_count), landmarks_count - 1);
+			if (!is_sector_used[sector])
+			{
+				is_sector_used[sector] = true;
+				is_selected[id] = true;
+				landmarks.push_back(id);
+			}
+		}
+		// пустые секторы добираются самыми удалёнными из оставшихся остановок
+		for (const auto& [distance, id] : stops_by_distance)
+		{
+			if (landmarks.size() == landmarks_count)
+			{
+				break;
+			}
+			if (!is_selected[id])
+			{
+				is_selected[id] = true;
+				landmarks.push_back(id);
+			}
+		}
+		return landmarks;
+	}
+
+	std::optional<TransportRouter::Router::RouteInfo> TransportRouter::FindRoute(size_t from_id, size_t to_id) const
+	{
+		if (router_ && router_->HasRow(from_id))
+		{
+			return router_->BuildRoute(from_id, to_id);
+		}
+		switch (settings_.router_type)
+		{
+		case RouterType::CONTRACTION_HIERARCHY:
+			return contraction_hierarchy_->BuildRoute(from_id, to_id);
+		case RouterType::A_STAR:
+		{
+			const geo::Coordinates target = vertex_coordinates_.at(to_id);
+			return dijkstra_router_->BuildRoute(from_id, to_id, [this, &target](graph::VertexId vertex)
+			{
+				return ComputeTimeLowerBound(vertex, target);
+			});
+		}
+		case RouterType::ALT:
+			return dijkstra_router_->BuildRoute(from_id, to_id, landmarks_->MakePotential(to_id));
+		case RouterType::ALL_PAIRS:  // сюда доходят только отправления без предрасчитанной строки
+		case RouterType::DIJKSTRA:
+		default:
+			return dijkstra_router_->BuildRoute(from_id, to_id);
+		}
+	}
+
+	bool TransportRouter::IsTreeSearchPreferred(size_t from_id, size_t targets_count) const
+	{
+		// начиная с этого числа целей одно дерево кратчайших путей выгоднее отдельных
+		// направленных запросов A*, ALT и иерархии сжатий
+		constexpr size_t MIN_TREE_TARGETS = 8;
+		if (router_ && router_->HasRow(from_id))
+		{
+			return false;
+		}
+		switch (settings_.router_type)
+		{
+		case RouterType::ALL_PAIRS:
+		case RouterType::DIJKSTRA:
+			return true;
+		default:
+			return targets_count >= MIN_TREE_TARGETS;
+		}
+	}
+
+	std::vector<std::optional<TransportRouter::Router::RouteInfo>> TransportRouter::FindRoutes(size_t from_id,
+		const std::vector<graph::VertexId>& to_ids) const
+	{
+		if (IsTreeSearchPreferred(from_id, to_ids.size()))
+		{
+			return dijkstra_router_->BuildRoutes(from_id, to_ids);
+		}
+		std::vector<std::optional<Router::RouteInfo>> result;
+		result.reserve(to_ids.size());
+		for (const auto to_id : to_ids)
+		{
+			result.push_back(FindRoute(from_id, to_id));
+		}
+		return result;
+	}
+
+	std::vector<std::optional<double>> TransportRouter::FindDurations(size_t from_id,
+		const std::vector<graph::VertexId>& to_ids) const
+	{
+		if (settings_.router_type == RouterType::RAPTOR)
+		{
+			return raptor_router_->ComputeDurations(from_id, to_ids);
+		}
+		std::vector<std::optional<double>> result;
+		result.reserve(to_ids.size());
+		// метки-хабы отвечают на запрос времени слиянием двух коротких массивов, без поиска по графу
+		if (hub_labels_)
+		{
+			for (const auto to_id : to_ids)
+			{
+				const auto weight = hub_labels_->ComputeWeight(from_id, to_id);
+				result.push_back(weight ? std::optional<double>(weight->total_time) : std::nullopt);
+			}
+			return result;
+		}
+		if (IsTreeSearchPreferred(from_id, to_ids.size()))
+		{
+			for (const auto& weight : dijkstra_router_->ComputeWeights(from_id, to_ids))
+			{
+				result.push_back(weight ? std::optional<double>(weight->total_time) : std::nullopt);
+			}
+			return result;
+		}
+		for (const auto to_id : to_ids)
+		{
+			const auto route = FindRoute(from_id, to_id);
+			result.push_back(route ? std::optional<double>(route->weight.total_time) : std::nullopt);
+		}
+		return result;
+	}
+
+	std::vector<graph::VertexId> TransportRouter::GetHotStopIds() const
+	{
+		std::vector<graph::VertexId> result;
+		std::unordered_set<graph::VertexId> added;
+		for (const auto& name : settings_.hot_stops)
+		{
+			const Stop* stop = catalogue_.FindStop(name);
+			if (stop && added.insert(stop->id).second)
+			{
+				result.push_back(stop->id);
+			}
+		}
+		return result;
+	}
+
+	std::vector<graph::VertexId> TransportRouter::GetStopIds(const std::vector<std::string>& stop_names) const
+	{
+		std::vector<graph::VertexId> result;
+		result.reserve(stop_names.size());
+		for (const auto& name : stop_names)
+		{
+			result.push_back(catalogue_.GetStopId(name));
+		}
+		return result;
 	}
 
 	std::optional<TransportRouter::TransportRoute> TransportRouter::BuildRoute(const std::string& from, const std::string& to)
@@ -49,22 +530,300 @@ namespace transport_catalogue
 			return TransportRoute{};
 		}
 		InitRouter();
-		auto from_id = id_by_stop_name_.at(from);
-		auto to_id = id_by_stop_name_.at(to);
-		auto route = router_->BuildRoute(from_id, to_id);
-		if (!route)
+		auto from_id = catalogue_.GetStopId(from);
+		auto to_id = catalogue_.GetStopId(to);
+		auto cached_route = route_cache_ ? route_cache_->Find({ from_id, to_id }) : std::nullopt;
+		if (!cached_route)
+		{
+			cached_route = ComputeRoute(from_id, to_id);
+			if (route_cache_)
+			{
+				route_cache_->Insert({ from_id, to_id }, *cached_route);
+			}
+		}
+		if (!*cached_route)
 		{
 			return std::nullopt;
 		}
+		return **cached_route;
+	}
+
+	TransportRouter::CachedRoute TransportRouter::ComputeRoute(size_t from_id, size_t to_id) const
+	{
+		if (settings_.router_type == RouterType::RAPTOR)
+		{
+			return MakeCachedRoute(raptor_router_->BuildRoute(from_id, to_id));
+		}
+		return MakeCachedRoute(FindRoute(from_id, to_id));
+	}
 
+	std::vector<TransportRouter::CachedRoute> TransportRouter::ComputeRoutes(size_t from_id,
+		const std::vector<graph::VertexId>& to_ids) const
+	{
+		std::vector<CachedRoute> result;
+		result.reserve(to_ids.size());
+		if (settings_.router_type == RouterType::RAPTOR)
+		{
+			for (const auto& journey : raptor_router_->BuildRoutes(from_id, to_ids))
+			{
+				result.push_back(MakeCachedRoute(journey));
+			}
+			return result;
+		}
+		for (const auto& route : FindRoutes(from_id, to_ids))
+		{
+			result.push_back(MakeCachedRoute(route));
+		}
+		return result;
+	}
+
+	TransportRouter::CachedRoute TransportRouter::MakeCachedRoute(const std::optional<Router::RouteInfo>& route) const
+	{
+		if (!route)
+		{
+			return nullptr;
+		}
+		return std::make_shared<const TransportRoute>(MakeTransportRoute(route->edges));
+	}
+
+	TransportRouter::CachedRoute TransportRouter::MakeCachedRoute(const std::optional<RaptorRouter::Journey>& journey) const
+	{
+		if (!journey)
+		{
+			return nullptr;
+		}
+		return std::make_shared<const TransportRoute>(MakeTransportRoute(*journey));
+	}
+
+	std::vector<TransportRouter::TransportRoute> TransportRouter::BuildParetoRoutes(const std::string& from,
+		const std::string& to, size_t max_boardings)
+	{
+		if (from == to)
+		{
+			return { TransportRoute{} };
+		}
+		InitRouter();
+		std::vector<TransportRoute> result;
+		for (const auto& journey : raptor_router_->BuildParetoRoutes(catalogue_.GetStopId(from), catalogue_.GetStopId(to), max_boardings))
+		{
+			result.push_back(MakeTransportRoute(journey));
+		}
+		return result;
+	}
+
+	std::vector<TransportRouter::TransportRoute> TransportRouter::BuildAlternativeRoutes(const std::string& from,
+		const std::string& to, size_t count)
+	{
+		if (count == 0)
+		{
+			return {};
+		}
+		if (from == to)
+		{
+			return { TransportRoute{} };
+		}
+		InitRouter();
+		std::vector<TransportRoute> result;
+		if (settings_.router_type == RouterType::RAPTOR)
+		{
+			if (auto route = BuildRoute(from, to))
+			{
+				result.push_back(std::move(*route));
+			}
+			return result;
+		}
+		// путь графа без повторов остановок может оказаться той же поездкой, где автобус покинут
+		// и тут же взят снова: такие пути отличаются от найденных только ожиданием и отвергаются.
+		// Сравниваются последовательности автобусов со склеенными подряд идущими поездками
+		std::set<std::vector<BusId>> bus_sequences;
+		const auto is_new_journey = [this, &bus_sequences](const std::vector<graph::EdgeId>& edges)
+		{
+			std::vector<BusId> buses;
+			for (const graph::EdgeId edge_id : edges)
+			{
+				const BusId bus_id = graph_.GetEdge(edge_id).weight.bus_id;
+				if (buses.empty() || buses.back() != bus_id)
+				{
+					buses.push_back(bus_id);
+				}
+			}
+			return bus_sequences.insert(std::move(buses)).second;
+		};
+		const auto routes = k_shortest_paths_->BuildRoutes(catalogue_.GetStopId(from), catalogue_.GetStopId(to), count,
+			is_new_journey, count * MAX_PATHS_PER_ALTERNATIVE);
+		for (const auto& route : routes)
+		{
+			result.push_back(MakeTransportRoute(route.edges));
+		}
+		return result;
+	}
+
+	std::vector<std::pair<std::string_view, double>> TransportRouter::ComputeIsochrone(const std::string& from, double max_time)
+	{
+		InitRouter();
+		const auto from_id = catalogue_.GetStopId(from);
+		std::vector<std::pair<std::string_view, double>> result;
+		if (settings_.router_type == RouterType::RAPTOR)
+		{
+			for (const auto& [stop_id, time] : raptor_router_->ComputeReachable(from_id, max_time))
+			{
+				result.emplace_back(catalogue_.GetStopName(static_cast<StopId>(stop_id)), time);
+			}
+			return result;
+		}
+
+		RouteWeight max_weight;
+		max_weight.total_time = max_time;
+		// вершины поездки модели с пересадками - не остановки, в ответ они не входят
+		const size_t stops_count = catalogue_.GetStopCount();
+		for (const auto& [vertex, weight] : dijkstra_router_->ComputeReachable(from_id, max_weight))
+		{
+			if (vertex < stops_count)
+			{
+				result.emplace_back(catalogue_.GetStopName(static_cast<StopId>(vertex)), weight.total_time);
+			}
+		}
+		return result;
+	}
+
+	TransportRouter::RouteCacheStatistics TransportRouter::GetRouteCacheStatistics() const
+	{
+		if (!route_cache_)
+		{
+			return {};
+		}
+		const auto statistics = route_cache_->GetStatistics();
+		return { statistics.hits, statistics.misses };
+	}
+
+	std::vector<std::optional<TransportRouter::TransportRoute>> TransportRouter::BuildRoutes(const std::string& from,
+		const std::vector<std::string>& to)
+	{
+		InitRouter();
+		const auto from_id = catalogue_.GetStopId(from);
+		const auto to_ids = GetStopIds(to);
+
+		// маршруты из кэша; в пакетный поиск уходят только недостающие цели
+		std::vector<CachedRoute> cached_routes(to_ids.size());
+		std::vector<size_t> missing_indices;
+		std::vector<graph::VertexId> missing_ids;
+		for (size_t i = 0; i < to_ids.size(); ++i)
+		{
+			if (to_ids[i] == from_id)
+			{
+				continue;
+			}
+			auto cached_route = route_cache_ ? route_cache_->Find({ from_id, to_ids[i] }) : std::nullopt;
+			if (cached_route)
+			{
+				cached_routes[i] = std::move(*cached_route);
+			}
+			else
+			{
+				missing_indices.push_back(i);
+				missing_ids.push_back(to_ids[i]);
+			}
+		}
+		auto routes = ComputeRoutes(from_id, missing_ids);
+		for (size_t i = 0; i < missing_indices.size(); ++i)
+		{
+			cached_routes[missing_indices[i]] = std::move(routes[i]);
+			if (route_cache_)
+			{
+				route_cache_->Insert({ from_id, missing_ids[i] }, cached_routes[missing_indices[i]]);
+			}
+		}
+
+		std::vector<std::optional<TransportRoute>> result;
+		result.reserve(to_ids.size());
+		for (size_t i = 0; i < to_ids.size(); ++i)
+		{
+			// маршрут в ту же остановку пустой, как и в BuildRoute
+			if (to_ids[i] == from_id)
+			{
+				result.push_back(TransportRoute{});
+			}
+			else if (cached_routes[i])
+			{
+				result.push_back(*cached_routes[i]);
+			}
+			else
+			{
+				result.push_back(std::nullopt);
+			}
+		}
+		return result;
+	}
+
+	TransportRouter::DurationMatrix TransportRouter::ComputeDurationMatrix(const std::vector<std::string>& from,
+		const std::vector<std::string>& to)
+	{
+		InitRouter();
+		const auto from_ids = GetStopIds(from);
+		const auto to_ids = GetStopIds(to);
+
+		DurationMatrix result(from_ids.size());
+		const auto compute_row = [this, &from_ids, &to_ids, &result](size_t row)
+		{
+			result[row] = FindDurations(from_ids[row], to_ids);
+		};
+		if (from_ids.size() < MIN_PARALLEL_MATRIX_ROWS)
+		{
+			for (size_t row = 0; row < from_ids.size(); ++row)
+			{
+				compute_row(row);
+			}
+			return result;
+		}
+		std::lock_guard lock(thread_pool_mutex_);
+		if (!thread_pool_)
+		{
+			thread_pool_ = std::make_unique<parallel::ThreadPool>();
+		}
+		thread_pool_->Run(from_ids.size(), compute_row);
+		return result;
+	}
+
+	TransportRouter::TransportRoute TransportRouter::MakeTransportRoute(const std::vector<graph::EdgeId>& edges) const
+	{
 		TransportRoute result;
-		for (auto edge_id : route->edges)
+		if (settings_.graph_model == GraphModel::TRANSFER)
+		{
+			// вершины [0, stops_count) - остановки, остальные - вершины поездки; поездка начинается
+			// с посадки на остановке, продолжается по рёбрам маршрута и заканчивается высадкой
+			const size_t stops_count = catalogue_.GetStopCount();
+			RouterEdge route_edge;
+			for (auto edge_id : edges)
+			{
+				const auto edge = graph_.GetEdge(edge_id);
+				if (edge.from < stops_count)
+				{
+					route_edge = RouterEdge{};
+					route_edge.bus_name = catalogue_.GetBusName(edge.weight.bus_id);
+					route_edge.stop_from = catalogue_.GetStopName(static_cast<StopId>(edge.from));
+					route_edge.total_time = edge.weight.total_time;
+				}
+				else if (edge.to >= stops_count)
+				{
+					route_edge.total_time += edge.weight.total_time;
+					route_edge.span_count += edge.weight.span_count;
+				}
+				else
+				{
+					route_edge.stop_to = catalogue_.GetStopName(static_cast<StopId>(edge.to));
+					result.push_back(route_edge);
+				}
+			}
+			return result;
+		}
+
+		for (auto edge_id : edges)
 		{
-			const auto& edge = graph_.GetEdge(edge_id);
+			const auto edge = graph_.GetEdge(edge_id);
 			RouterEdge route_edge;
-			route_edge.bus_name = edge.weight.bus_name;
-			route_edge.stop_from = stops_by_id_.at(edge.from)->name;
-			route_edge.stop_to = stops_by_id_.at(edge.to)->name;
+			route_edge.bus_name = catalogue_.GetBusName(edge.weight.bus_id);
+			route_edge.stop_from = catalogue_.GetStopName(static_cast<StopId>(edge.from));
+			route_edge.stop_to = catalogue_.GetStopName(static_cast<StopId>(edge.to));
 			route_edge.span_count = edge.weight.span_count;
 			route_edge.total_time = edge.weight.total_time;
 			result.push_back(route_edge);
@@ -72,6 +831,23 @@ namespace transport_catalogue
 		return result;
 	}
 
+	TransportRouter::TransportRoute TransportRouter::MakeTransportRoute(const RaptorRouter::Journey& journey) const
+	{
+		TransportRoute result;
+		result.reserve(journey.size());
+		for (const auto& ride : journey)
+		{
+			RouterEdge route_edge;
+			route_edge.bus_name = ride.bus_name;
+			route_edge.stop_from = catalogue_.GetStopName(static_cast<StopId>(ride.stop_from));
+			route_edge.stop_to = catalogue_.GetStopName(static_cast<StopId>(ride.stop_to));
+			route_edge.span_count = ride.span_count;
+			route_edge.total_time = ride.total_time;
+			result.push_back(route_edge);
+		}
+		return result;
+	}
+
 	const RoutingSettings& TransportRouter::GetSettings() const
 	{
 		return settings_;
@@ -96,80 +872,146 @@ namespace transport_catalogue
 		return router_;
 	}
 
-	TransportRouter::StopsById& TransportRouter::GetStopsById() {
-		return stops_by_id_;
+	std::unique_ptr<TransportRouter::ContractionHierarchy>& TransportRouter::GetContractionHierarchy() {
+		return contraction_hierarchy_;
+	}
+	const std::unique_ptr<TransportRouter::ContractionHierarchy>& TransportRouter::GetContractionHierarchy() const {
+		return contraction_hierarchy_;
+	}
+
+	std::unique_ptr<TransportRouter::Landmarks>& TransportRouter::GetLandmarks() {
+		return landmarks_;
 	}
-	const TransportRouter::StopsById& TransportRouter::GetStopsById() const {
-		return stops_by_id_;
+	const std::unique_ptr<TransportRouter::Landmarks>& TransportRouter::GetLandmarks() const {
+		return landmarks_;
 	}
 
-	TransportRouter::IdsByStopName& TransportRouter::GetIdsByStopName() {
-		return id_by_stop_name_;
+	std::unique_ptr<TransportRouter::HubLabels>& TransportRouter::GetHubLabels() {
+		return hub_labels_;
 	}
-	const TransportRouter::IdsByStopName& TransportRouter::GetIdsByStopName() const {
-		return id_by_stop_name_;
+	const std::unique_ptr<TransportRouter::HubLabels>& TransportRouter::GetHubLabels() const {
+		return hub_labels_;
 	}
 
-	void TransportRouter::BuildEdges()
+	void TransportRouter::BuildEdges(GraphBuilder& graph)
 	{
 		for (const auto& [route_name, route] : catalogue_.GetBusnameToBus())
 		{
-			int stops_count = static_cast<int>(route->stops.size());
-			for (int i = 0; i < stops_count - 1; ++i)
+			AddBusEdges(graph, route);
+		}
+	}
+
+	void TransportRouter::AddBusEdges(GraphBuilder& graph, const Bus* route)
+	{
+		int stops_count = static_cast<int>(catalogue_.GetBusStops(route->id).size());
+		for (int i = 0; i < stops_count - 1; ++i)
+		{
+			double route_time = settings_.wait_time;
+			double route_time_back = settings_.wait_time;
+			for (int j = i + 1; j < stops_count; ++j)
 			{
-				double route_time = settings_.wait_time;
-				double route_time_back = settings_.wait_time;
-				for (int j = i + 1; j < stops_count; ++j)
+				graph::Edge<RouteWeight> edge = MakeEdge(route, i, j);
+				route_time += ComputeRouteTime(route, j - 1, j);
+				edge.weight.total_time = route_time;
+				graph.AddEdge(edge);
+
+				if (!route->is_roundtrip)
 				{
-					graph::Edge<RouteWeight> edge = MakeEdge(route, i, j);
-					route_time += ComputeRouteTime(route, j - 1, j);
-					edge.weight.total_time = route_time;
-					graph_.AddEdge(edge);
-
-					if (!route->is_roundtrip)
-					{
-						int i_back = stops_count - 1 - i;
-						int j_back = stops_count - 1 - j;
-						graph::Edge<RouteWeight> edge = MakeEdge(route, i_back, j_back);
-						route_time_back += ComputeRouteTime(route, j_back + 1, j_back);
-						edge.weight.total_time = route_time_back;
-						graph_.AddEdge(edge);
-					}
+					int i_back = stops_count - 1 - i;
+					int j_back = stops_count - 1 - j;
+					graph::Edge<RouteWeight> edge = MakeEdge(route, i_back, j_back);
+					route_time_back += ComputeRouteTime(route, j_back + 1, j_back);
+					edge.weight.total_time = route_time_back;
+					graph.AddEdge(edge);
 				}
 			}
 		}
 	}
 
-	size_t TransportRouter::CountStops()
+	void TransportRouter::BuildTransferEdges(GraphBuilder& graph, graph::VertexId first_ride_vertex)
+	{
+		graph::VertexId ride_vertex = first_ride_vertex;
+		for (const auto& [route_name, route] : catalogue_.GetBusnameToBus())
+		{
+			AddBusRideChains(graph, route, ride_vertex);
+		}
+	}
+
+	void TransportRouter::AddBusRideChains(GraphBuilder& graph, const Bus* route, graph::VertexId& ride_vertex)
+	{
+		const int stops_count = static_cast<int>(catalogue_.GetBusStops(route->id).size());
+		std::vector<int> stop_indices(static_cast<size_t>(stops_count));
+		for (int i = 0; i < stops_count; ++i)
+		{
+			stop_indices[static_cast<size_t>(i)] = i;
+		}
+		AddRideChain(graph, route, stop_indices, ride_vertex);
+		if (!route->is_roundtrip)
+		{
+			std::reverse(stop_indices.begin(), stop_indices.end());
+			AddRideChain(graph, route, stop_indices, ride_vertex);
+		}
+	}
+
+	void TransportRouter::AddRideChain(GraphBuilder& graph, const Bus* bus, const std::vector<int>& stop_indices,
+		graph::VertexId& ride_vertex)
+	{
+		const auto stops = catalogue_.GetBusStops(bus->id);
+		const size_t chain_size = stop_indices.size();
+		for (size_t i = 0; i < chain_size; ++i, ++ride_vertex)
+		{
+			const graph::VertexId stop_vertex = stops[static_cast<size_t>(stop_indices[i])];
+			if (i + 1 < chain_size)
+			{
+				// посадка: ожидание автобуса на остановке
+				graph.AddEdge({ stop_vertex, ride_vertex, RouteWeight{ bus->id, static_cast<double>(settings_.wait_time), 0 } });
+				// проезд до следующей остановки маршрута
+				const double route_time = ComputeRouteTime(bus, stop_indices[i], stop_indices[i + 1]);
+				graph.AddEdge({ ride_vertex, ride_vertex + 1, RouteWeight{ bus->id, route_time, 1 } });
+			}
+			// высадка
+			if (i > 0)
+			{
+				graph.AddEdge({ ride_vertex, stop_vertex, RouteWeight{ bus->id, 0, 0 } });
+			}
+		}
+	}
+
+	size_t TransportRouter::CountRideVertices() const
 	{
-		size_t stops_counter = 0;
-		const auto& stops = catalogue_.GetStopnameToStop();
-		id_by_stop_name_.reserve(stops.size());
-		stops_by_id_.reserve(stops.size());
-		for (auto stop : stops)
+		// по вершине поездки на каждую остановку маршрута в каждом направлении движения
+		size_t ride_vertices_count = 0;
+		for (const auto& [route_name, route] : catalogue_.GetBusnameToBus())
 		{
-			id_by_stop_name_.insert({ stop.first, stops_counter });
-			stops_by_id_.insert({ stops_counter++, stop.second });
+			ride_vertices_count += CountRideVertices(*route);
 		}
-		return stops_counter;
+		return ride_vertices_count;
+	}
+
+	size_t TransportRouter::CountRideVertices(const Bus& bus) const
+	{
+		const size_t stops_count = catalogue_.GetBusStops(bus.id).size();
+		return bus.is_roundtrip ? stops_count : stops_count * 2;
 	}
 
 	graph::Edge<RouteWeight> TransportRouter::MakeEdge(const Bus* bus, int stop_from_index, int stop_to_index)
 	{
 		graph::Edge<RouteWeight> edge;
-		edge.from = id_by_stop_name_.at(bus->stops.at(static_cast<size_t>(stop_from_index))->name);
-		edge.to = id_by_stop_name_.at(bus->stops.at(static_cast<size_t>(stop_to_index))->name);
-		edge.weight.bus_name = bus->name;
-		edge.weight.span_count = static_cast<int>(stop_to_index - stop_from_index);
+		const auto stops = catalogue_.GetBusStops(bus->id);
+		edge.from = stops[static_cast<size_t>(stop_from_index)];
+		edge.to = stops[static_cast<size_t>(stop_to_index)];
+		edge.weight.bus_id = bus->id;
+		edge.weight.span_count = std::abs(stop_to_index - stop_from_index);
 		return edge;
 	}
 
 	double TransportRouter::ComputeRouteTime(const Bus* bus, int stop_from_index, int stop_to_index)
 	{
+		const auto stops = catalogue_.GetBusStops(bus->id);
 		auto split_distance = catalogue_.GetDistance
 		(
-			bus->stops.at(static_cast<size_t>(stop_from_index)),
-			bus->stops.at(static_cast<size_t>(stop_to_index))
+			stops[static_cast<size_t>(stop_from_index)],
+			stops[static_cast<size_t>(stop_to_index)]
 		);
 		return split_distance / settings_.velocity;
 	}
@@ -1,13 +1,24 @@
 #pragma once
 
+#include "contraction_hierarchy.h"
+#include "dijkstra_router.h"
+#include "frozen_graph.h"
 #include "graph.h"
+#include "hub_labels.h"
+#include "k_shortest_paths.h"
+#include "landmarks.h"
+#include "lru_cache.h"
+#include "parallel.h"
+#include "raptor.h"
 #include "router.h"
 #include "transport_catalogue.h"
 
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 #include <unordered_map>
 
@@ -18,21 +29,68 @@ namespace transport_catalogue
 
 	struct RouteWeight
 	{
-		std::string_view bus_name;
+		BusId bus_id = 0;
 		double total_time = 0;
 		int span_count = 0;
 	};
 
+	// способ поиска маршрутов
+	enum class RouterType
+	{
+		ALL_PAIRS,  // предрасчёт маршрутов между всеми парами остановок
+		DIJKSTRA,   // поиск по запросу без предрасчёта
+		CONTRACTION_HIERARCHY,  // двунаправленный поиск по предрасчитанной иерархии сжатий
+		A_STAR,     // поиск по запросу, направляемый нижней оценкой времени по расстоянию на сфере
+		ALT,        // A* с оценкой по предрасчитанным временам до опорных остановок и от них
+		RAPTOR,     // поиск по раундам пересадок прямо по маршрутам автобусов, без графа
+	};
+
+	// модель графа маршрутов
+	enum class GraphModel
+	{
+		COMPLETE,  // ребро между каждой парой остановок одного автобуса: O(k²) рёбер на маршрут
+		TRANSFER,  // вершины ожидания на остановках и вершины поездки вдоль маршрута: O(k) рёбер
+	};
+
 	struct RoutingSettings
 	{
 		int wait_time = 0;      // в минутах
 		double velocity = 100;  // в метрах-в-минуту
+		RouterType router_type = RouterType::ALL_PAIRS;
+		GraphModel graph_model = GraphModel::COMPLETE;
+		int landmarks_count = 16;  // число опорных остановок для ALT
+		int route_cache_capacity = 4096;  // число маршрутов в кэше, 0 - без кэша
+		bool hub_labels = false;  // строить индекс меток-хабов для запросов только времени в пути
+		graph::PrecomputeMethod all_pairs_method = graph::PrecomputeMethod::FLOYD_WARSHALL;  // предрасчёт ALL_PAIRS
+		// остановки, из которых маршруты до всех остальных предрасчитываются заранее;
+		// из прочих ищутся по запросу. Для ALL_PAIRS непустой список заменяет полную матрицу
+		std::vector<std::string> hot_stops;
 	};
+}  // namespace transport_catalogue
+
+namespace graph
+{
+	// для сравнения маршрутов важно только время в пути
+	template <>
+	struct WeightTraits<transport_catalogue::RouteWeight>
+	{
+		using Key = double;
 
-	bool operator<(const RouteWeight& left, const RouteWeight& right);
-	bool operator>(const RouteWeight& left, const RouteWeight& right);
-	RouteWeight operator+(const RouteWeight& left, const RouteWeight& right);
+		static Key ToKey(const transport_catalogue::RouteWeight& weight)
+		{
+			return weight.total_time;
+		}
+		static transport_catalogue::RouteWeight FromKey(Key key)
+		{
+			transport_catalogue::RouteWeight weight;
+			weight.total_time = key;
+			return weight;
+		}
+	};
+}  // namespace graph
 
+namespace transport_catalogue
+{
 	class TransportRouter
 	{
 	public:
@@ -46,20 +104,75 @@ namespace transport_catalogue
 			int span_count = 0;
 		};
 
-		using Graph = graph::DirectedWeightedGraph<RouteWeight>;
-		using StopsById = std::unordered_map<size_t, const Stop*>;
-		using IdsByStopName = std::unordered_map<std::string_view, size_t>;
+		// граф собирается по автобусам в изменяемом виде и замораживается для поиска
+		using GraphBuilder = graph::DirectedWeightedGraph<RouteWeight>;
+		using Graph = graph::FrozenGraph<RouteWeight>;
 		using Router = graph::Router<RouteWeight>;
+		using DijkstraRouter = graph::DijkstraRouter<RouteWeight>;
+		using ContractionHierarchy = graph::ContractionHierarchy<RouteWeight>;
+		using Landmarks = graph::Landmarks<RouteWeight>;
+		using HubLabels = graph::HubLabels<RouteWeight>;
+		using KShortestPaths = graph::KShortestPaths<RouteWeight>;
 		using TransportRoute = std::vector<RouterEdge>;
+		// время в пути в минутах для каждой пары (отправление, прибытие); пусто, если пути нет
+		using DurationMatrix = std::vector<std::vector<std::optional<double>>>;
+
+		struct RouteCacheStatistics
+		{
+			size_t hits = 0;
+			size_t misses = 0;
+		};
+
+		// итог обновления после изменения автобусов
+		struct UpdateStatistics
+		{
+			size_t removed_edges = 0;
+			size_t added_edges = 0;
+			size_t repaired_rows = 0;  // пересчитанные строки матрицы маршрутов
+			bool is_rebuilt = false;   // граф и индексы построены заново, а не починены
+		};
 
 		TransportRouter(const transport_catalogue::TransportCatalogue& catalogue, const RoutingSettings& settings);
 
-		void InitRouter();
+		// progress сообщает о ходе предрасчёта матрицы маршрутов ALL_PAIRS
+		void InitRouter(const graph::ProgressCallback& progress = nullptr);
         
         void InternalInit();
 
+		// Перестраивает граф после того, как автобусы bus_names в справочнике добавлены, изменены
+		// или удалены; набор остановок должен остаться прежним. Рёбра остальных автобусов
+		// сохраняются, матрица маршрутов чинится точечно (Router::Repair), а иерархия сжатий,
+		// опорные остановки и метки-хабы строятся заново. Если у TRANSFER после обновлений
+		// слишком много вершин поездки остаётся без рёбер, всё строится заново, как в InitRouter.
+		// progress сообщает о ремонте или предрасчёте матрицы
+		UpdateStatistics UpdateBuses(const std::vector<std::string>& bus_names, const graph::ProgressCallback& progress = nullptr);
+
 		std::optional<TransportRoute> BuildRoute(const std::string& from, const std::string& to);
 
+		// маршруты из одной остановки во многие: ответ i соответствует to[i]
+		std::vector<std::optional<TransportRoute>> BuildRoutes(const std::string& from, const std::vector<std::string>& to);
+
+		// матрица времён в пути; строки матрицы считаются параллельно в общем пуле роутера,
+		// одновременные вызовы занимают пул по очереди
+		DurationMatrix ComputeDurationMatrix(const std::vector<std::string>& from, const std::vector<std::string>& to);
+
+		// варианты маршрута, оптимальные по Парето по времени и числу посадок, от меньшего
+		// числа посадок к большему; считаются RAPTOR при любом способе поиска маршрутов
+		std::vector<TransportRoute> BuildParetoRoutes(const std::string& from, const std::string& to, size_t max_boardings);
+
+		// до count различных маршрутов без повторных заездов на остановки по возрастанию времени
+		// в пути (алгоритм Йена по графу маршрутов); первый из них совпадает с BuildRoute.
+		// Маршруты с одной и той же последовательностью автобусов считаются одной поездкой.
+		// RAPTOR графа не строит, для него возвращается только лучший маршрут
+		std::vector<TransportRoute> BuildAlternativeRoutes(const std::string& from, const std::string& to, size_t count);
+
+		// остановки, до которых можно доехать из from не дольше чем за max_time минут,
+		// и время в пути до них по возрастанию; сама from входит с нулевым временем
+		std::vector<std::pair<std::string_view, double>> ComputeIsochrone(const std::string& from, double max_time);
+
+		// обращения BuildRoute и BuildRoutes к кэшу маршрутов
+		RouteCacheStatistics GetRouteCacheStatistics() const;
+
 		const RoutingSettings& GetSettings() const;
 		RoutingSettings& GetSettings();
 
@@ -69,25 +182,87 @@ namespace transport_catalogue
     std::unique_ptr<Router>& GetRouter();
     const std::unique_ptr<Router>& GetRouter() const;
 
-    StopsById& GetStopsById();
-    const StopsById& GetStopsById() const;
+    std::unique_ptr<ContractionHierarchy>& GetContractionHierarchy();
+    const std::unique_ptr<ContractionHierarchy>& GetContractionHierarchy() const;
 
-    IdsByStopName& GetIdsByStopName();
-    const IdsByStopName& GetIdsByStopName() const;
+    std::unique_ptr<Landmarks>& GetLandmarks();
+    const std::unique_ptr<Landmarks>& GetLandmarks() const;
+
+    std::unique_ptr<HubLabels>& GetHubLabels();
+    const std::unique_ptr<HubLabels>& GetHubLabels() const;
         
 	private:
+		struct RouteIdsHasher
+		{
+			size_t operator()(const std::pair<graph::VertexId, graph::VertexId>& ids) const;
+		};
+
+		// готовый маршрут либо nullptr, если пути нет; разделяется между кэшем и ответами
+		using CachedRoute = std::shared_ptr<const TransportRoute>;
+		using RouteCache = cache::ShardedLruCache<std::pair<graph::VertexId, graph::VertexId>, CachedRoute, RouteIdsHasher>;
+
         bool is_initialized_ = false;
 		const transport_catalogue::TransportCatalogue& catalogue_;
 		RoutingSettings settings_;
 
-		StopsById stops_by_id_;
-		IdsByStopName id_by_stop_name_;
-
 		Graph graph_;
 		mutable std::unique_ptr<Router> router_;
+		std::unique_ptr<DijkstraRouter> dijkstra_router_;
+		std::unique_ptr<KShortestPaths> k_shortest_paths_;
+		std::unique_ptr<ContractionHierarchy> contraction_hierarchy_;
+		std::unique_ptr<Landmarks> landmarks_;
+		std::unique_ptr<HubLabels> hub_labels_;
+		std::unique_ptr<RouteCache> route_cache_;
+		std::unique_ptr<RaptorRouter> raptor_router_;
+		// пул для матриц длительностей: создаётся при первой большой матрице и живёт вместе с роутером.
+		// ThreadPool::Run не допускает одновременных вызовов, поэтому пул занимается под мьютексом
+		std::unique_ptr<parallel::ThreadPool> thread_pool_;
+		std::mutex thread_pool_mutex_;
+
+		// данные нижней оценки времени для A*: координаты остановки каждой вершины графа
+		// и минимальное время проезда метра расстояния на сфере по всем рёбрам
+		std::vector<geo::Coordinates> vertex_coordinates_;
+		double min_time_per_meter_ = 0;
+
+		// сколько путей графа просматривает поиск альтернатив на каждый маршрут ответа: пути,
+		// повторяющие уже найденные поездки, пропускаются, но их число ограничено
+		static constexpr size_t MAX_PATHS_PER_ALTERNATIVE = 16;
+		// доля вершин поездки без рёбер, после которой UpdateBuses строит граф заново
+		static constexpr double MAX_FREE_RIDE_VERTICES_SHARE = 0.25;
+		// матрицы с меньшим числом строк считаются в вызывающем потоке: будить пул дольше
+		static constexpr size_t MIN_PARALLEL_MATRIX_ROWS = 8;
+
+		void InitSearchEngines();
+		void Rebuild(const graph::ProgressCallback& progress);
+		// размещает вершины поездки автобусов buses в отрезках номеров без используемых рёбер,
+		// при нехватке - в конце графа, увеличивая vertex_count. Возвращает число оставшихся
+		// свободных вершин поездки
+		size_t AllocateRideVertices(const std::vector<const Bus*>& buses, const std::vector<bool>& is_used_vertex,
+			std::vector<graph::VertexId>& first_ride_vertices, size_t& vertex_count) const;
+		void InitTimeLowerBound();
+		double ComputeTimeLowerBound(graph::VertexId vertex, const geo::Coordinates& target) const;
+		std::vector<graph::VertexId> SelectLandmarks() const;
+		std::optional<Router::RouteInfo> FindRoute(size_t from_id, size_t to_id) const;
+		std::vector<std::optional<Router::RouteInfo>> FindRoutes(size_t from_id, const std::vector<graph::VertexId>& to_ids) const;
+		CachedRoute ComputeRoute(size_t from_id, size_t to_id) const;
+		std::vector<CachedRoute> ComputeRoutes(size_t from_id, const std::vector<graph::VertexId>& to_ids) const;
+		std::vector<std::optional<double>> FindDurations(size_t from_id, const std::vector<graph::VertexId>& to_ids) const;
+		bool IsTreeSearchPreferred(size_t from_id, size_t targets_count) const;
+		// номера вершин горячих остановок из настроек без повторов; неизвестные имена пропускаются
+		std::vector<graph::VertexId> GetHotStopIds() const;
+		std::vector<graph::VertexId> GetStopIds(const std::vector<std::string>& stop_names) const;
+		TransportRoute MakeTransportRoute(const std::vector<graph::EdgeId>& edges) const;
+		TransportRoute MakeTransportRoute(const RaptorRouter::Journey& journey) const;
+		CachedRoute MakeCachedRoute(const std::optional<Router::RouteInfo>& route) const;
+		CachedRoute MakeCachedRoute(const std::optional<RaptorRouter::Journey>& journey) const;
 
-		void BuildEdges();
-		size_t CountStops();
+		void BuildEdges(GraphBuilder& graph);
+		void AddBusEdges(GraphBuilder& graph, const Bus* route);
+		void BuildTransferEdges(GraphBuilder& graph, graph::VertexId first_ride_vertex);
+		void AddBusRideChains(GraphBuilder& graph, const Bus* route, graph::VertexId& ride_vertex);
+		void AddRideChain(GraphBuilder& graph, const Bus* bus, const std::vector<int>& stop_indices, graph::VertexId& ride_vertex);
+		size_t CountRideVertices() const;
+		size_t CountRideVertices(const Bus& bus) const;
 		graph::Edge<RouteWeight> MakeEdge(const Bus* bus, int stop_from_index, int stop_to_index);
 		double ComputeRouteTime(const Bus* bus, int stop_from_index, int stop_to_index);
 	};